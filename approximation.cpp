@@ -1,5 +1,8 @@
 #include "approximation.h"
 
+#include "profile.h"
+#include "summation.h"
+
 class LinearApproximationException : public std::exception {
     public:
         [[nodiscard]] const char* what() const noexcept override {
@@ -7,39 +10,58 @@ class LinearApproximationException : public std::exception {
         }
     };
 
-std::pair<float, float> approx_lineal(std::vector<float> xs, std::vector<float> ys) {
-    auto squareSum =
-            [](float acc, float num)-> float {
-                return acc + (num * num);
-            };
+std::pair<float, float> approx_lineal(const std::vector<float> &xs, const std::vector<float> &ys) {
+    return approx_lineal(compute_moments(xs, ys, 1));
+}
 
-    float sx = std::accumulate(xs.begin(), xs.end(), 0.0f);
-    float sxx = std::accumulate(xs.begin(), xs.end(), 0.0f, squareSum);
+std::pair<float, float> approx_lineal(const float *xs, const float *ys, size_t n) {
+    return approx_lineal(compute_moments(xs, ys, n, 1));
+}
 
-    float sy = std::accumulate(ys.begin(), ys.end(), 0.0f);
-    float sxy = std::inner_product(xs.begin(), xs.end(), ys.begin(), 0.0f);
+std::pair<float, float> approx_lineal(const Moments &m) {
+    PROFILE_SCOPE("approx_lineal");
+    PROFILE_COUNT("solver_calls", 1);
 
-    unsigned int n = xs.size();
-    float delta_0 = sxx * n - sx * sx;
-    float delta_1 = sxy * n - sx * sy;
-    float delta_2 = sxx * sy - sx * sxy;
+    std::pair<float, float> line;
+    if (!try_lineal(m, line)) {
+        throw LinearApproximationException();
+    }
 
-    float a = delta_1 / delta_0;
-    float b = delta_2 / delta_0;
+    return line;
+}
 
-    /* checking the necessary condition the existence of a minimum for the function S */
-    float sum_1 = 0;
-    for (size_t i = 0; i < n; i++) {
-        sum_1 += (a * xs[i] + b - ys[i]) * xs[i];
+bool try_lineal(const Moments &m, std::pair<float, float> &line) {
+    if (m.degree < 1) {
+        throw std::runtime_error("Lineal approximation needs moments of degree 1 or higher!");
     }
 
-    float sum_2 = 0;
-    for (size_t i = 0; i < n; i++) {
-        sum_2 += (a * xs[i] + b - ys[i]);
+    /* solved like the other polynomial fits, x constant or close to it fails here; a_0 is b, a_1 is a */
+    PolyFit<1>::Vector solution;
+    if (!PolyFit<1>::try_solve(PolyFit<1>::power_sums(m), solution)) {
+        return false;
     }
 
-    sum_1 *= 2;
-    sum_2 *= 2;
+    /* the line in t of the moments, taken back to x once it is known to be the minimum */
+    float a = solution(1);
+    float b = solution(0);
+
+    double sx = m.sx[1];
+    double sxx = m.sx[2];
+
+    double sy = m.sxy[0];
+    double sxy = m.sxy[1];
+
+    double n = static_cast<double>(m.n);
+
+    /* checking the necessary condition the existence of a minimum for the function S
+     *
+     * dS/da = 2 * Σ(a*x_i + b - y_i) * x_i = 2 * (a * Σx^2 + b * Σx - Σxy)
+     * dS/db = 2 * Σ(a*x_i + b - y_i)       = 2 * (a * Σx + b * n - Σy)
+     *
+     * both derivatives are expressed through the moments, so the data is not scanned again
+     */
+    double sum_1 = 2 * ((double) a * sxx + (double) b * sx - sxy);
+    double sum_2 = 2 * ((double) a * sx + (double) b * n - sy);
 
     /*
      * A function is unbounded: If a function has no lower bound and continues to decrease indefinitely,
@@ -63,12 +85,43 @@ std::pair<float, float> approx_lineal(std::vector<float> xs, std::vector<float>
      * we can determine if they are close enough to zero.
      */
 
-    float epsilon = 1e-3;
+    /*
+     * a and b are rounded to float, so the derivatives at them are not 0 either,
+     * and epsilon is taken relative to the magnitude of the sums being compared
+     */
+    double epsilon = 1e-3;
 
-    if (std::abs(sum_1) < epsilon && std::abs(sum_2) < epsilon) {
-        return {a, b};
-    } else {
-        throw LinearApproximationException();
+    if (std::abs(sum_1) < epsilon * std::max(1.0, std::abs(sxy))
+        && std::abs(sum_2) < epsilon * std::max(1.0, std::abs(sy))) {
+        double slope = a / m.scaling.scale;
+        line = {static_cast<float>(slope), static_cast<float>(b - slope * m.scaling.center)};
+        return true;
+    }
+
+    return false;
+}
+
+std::pair<float, float> linear_regression(double n, double su, double suu, double sv, double suv) {
+    double B = (n * suv - su * sv) / (n * suu - su * su);
+    double A = (sv - B * su) / n;
+
+    return {static_cast<float>(A), static_cast<float>(B)};
+}
+
+namespace {
+    /* least squares line v = A + B * u through the points (u_i, v_i), the linearized fits differ only in u and v */
+    std::pair<float, float> regression_line(const float *us, const float *vs, size_t n) {
+        PROFILE_COUNT("points", n);
+        PROFILE_COUNT("solver_calls", 1);
+
+        std::array<float, 4> sums = compensated_sums<4>(n, [&](size_t i, std::array<float, 4> &s) {
+            s[0] += us[i];
+            s[1] += vs[i];
+            s[2] += us[i] * vs[i];
+            s[3] += us[i] * us[i];
+        });
+
+        return linear_regression(n, sums[0], sums[3], sums[1], sums[2]);
     }
 }
 
@@ -83,205 +136,154 @@ std::pair<float, float> approx_lineal(std::vector<float> xs, std::vector<float>
  * at the end we do the reverse change of variables => a = exp(A)
  */
 std::pair<float, float> approx_exponential(std::vector<float> &xs, std::vector<float> &ys) {
-    std::vector<float> ln_ys;
-    ln_ys.reserve(ys.size());
+    return approx_exponential(xs.data(), ys.data(), xs.size());
+}
+
+std::pair<float, float> approx_exponential(const float *xs, const float *ys, size_t size) {
+    PROFILE_SCOPE("approx_exponential");
 
     /* data linearization */
-    for (const auto& y : ys) {
-        ln_ys.push_back(std::log(y));
-    }
+    std::vector<float> ln_ys(size);
+    log_column(ys, ln_ys.data(), size);
 
-    float sum_xs = 0.0;
-    float sum_ln_ys = 0.0;
-    float sum_xs_ln_ys = 0.0;
-    float sum_xs_squared = 0.0;
+    std::pair<float, float> line = regression_line(xs, ln_ys.data(), size);
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        sum_xs += xs[i];
-        sum_ln_ys += ln_ys[i];
-        sum_xs_ln_ys += xs[i] * ln_ys[i];
-        sum_xs_squared += xs[i] * xs[i];
-    }
+    return {std::exp(line.first), line.second};
+}
 
-    float n = xs.size();
+std::pair<float, float> approx_exponential(const float *xs, const LogColumns &columns) {
+    PROFILE_SCOPE("approx_exponential");
+
+    if (!columns.hasLnY()) {
+        throw std::runtime_error("Exponential approximation needs all y to be positive!");
+    }
 
-    float B = (n * sum_xs_ln_ys - sum_xs * sum_ln_ys) / (n * sum_xs_squared - sum_xs * sum_xs);
-    float A = std::exp((sum_ln_ys - B * sum_xs) / n);
+    std::pair<float, float> line = regression_line(xs, columns.lnY.data(), columns.n);
 
-    return {A, B};
+    return {std::exp(line.first), line.second};
 }
 
 std::pair<float, float> approx_power(std::vector<float> &xs, std::vector<float> &ys) {
-    std::vector<float> ln_ys;
-    ln_ys.reserve(ys.size());
+    return approx_power(xs.data(), ys.data(), xs.size());
+}
 
-    std::vector<float> ln_xs;
-    ln_xs.reserve(xs.size());
+std::pair<float, float> approx_power(const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("approx_power");
 
-    size_t n = xs.size();
-    for (size_t i = 0; i < n; i++) {
-        ln_ys.push_back(std::log(ys[i]));
-        ln_xs.push_back(std::log(xs[i]));
-    }
+    std::vector<float> ln_ys(n);
+    log_column(ys, ln_ys.data(), n);
+
+    std::vector<float> ln_xs(n);
+    log_column(xs, ln_xs.data(), n);
+
+    std::pair<float, float> line = regression_line(ln_xs.data(), ln_ys.data(), n);
 
-    float sum_xs = 0.0;
-    float sum_ln_ys = 0.0;
-    float sum_xs_ln_ys = 0.0;
-    float sum_xs_squared = 0.0;
+    return {std::exp(line.first), line.second};
+}
+
+std::pair<float, float> approx_power(const LogColumns &columns) {
+    PROFILE_SCOPE("approx_power");
 
-    for (size_t i = 0; i < n; i++) {
-        sum_xs += ln_xs[i];
-        sum_ln_ys += ln_ys[i];
-        sum_xs_ln_ys += ln_xs[i] * ln_ys[i];
-        sum_xs_squared += ln_xs[i] * ln_xs[i];
+    if (!columns.hasLnX() || !columns.hasLnY()) {
+        throw std::runtime_error("Power approximation needs all x and y to be positive!");
     }
 
-    float B = (n * sum_xs_ln_ys - sum_xs * sum_ln_ys) / (n * sum_xs_squared - sum_xs * sum_xs);
-    float A = std::exp((sum_ln_ys - B * sum_xs) / n);
+    std::pair<float, float> line = regression_line(columns.lnX.data(), columns.lnY.data(), columns.n);
 
-    return {A, B};
+    return {std::exp(line.first), line.second};
 }
 
 //FIXME
 std::pair<float, float> approx_log(std::vector<float> &xs, std::vector<float> &ys) {
-    std::vector<float> ln_xs;
-    ln_xs.reserve(xs.size());
+    return approx_log(xs.data(), ys.data(), xs.size());
+}
 
-    size_t n = xs.size();
-    for (size_t i = 0; i < n; i++) {
-        ln_xs.push_back(std::log(xs[i]));
-    }
+std::pair<float, float> approx_log(const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("approx_log");
 
-    float sum_xs = 0.0;
-    float sum_ln_ys = 0.0;
-    float sum_xs_ln_ys = 0.0;
-    float sum_xs_squared = 0.0;
+    std::vector<float> ln_xs(n);
+    log_column(xs, ln_xs.data(), n);
 
-    for (size_t i = 0; i < n; i++) {
-        sum_xs += ln_xs[i];
-        sum_ln_ys += ys[i];
-        sum_xs_ln_ys += ln_xs[i] * ys[i];
-        sum_xs_squared += ln_xs[i] * ln_xs[i];
-    }
+    std::pair<float, float> line = regression_line(ln_xs.data(), ys, n);
 
-    float B = (n * sum_xs_ln_ys - sum_xs * sum_ln_ys) / (n * sum_xs_squared - sum_xs * sum_xs);
-    float A = (sum_ln_ys - B * sum_xs) / n;
-
-    return {B, A};
+    return {line.second, line.first};
 }
 
-/*
- *
- *
- * return value contains 3 float coefficients
- */
-//TODO: checking the necessary condition the existence of a minimum for the function S
-std::vector<float> quadratic_approximation(std::vector<float> xs, std::vector<float> ys) {
-    auto squareSum =
-            [](float acc, float num) -> float {
-                return acc + (num * num);
-            };
-
-    auto cubeSum = [](float acc, float num) -> float {
-        return acc + (num * num * num);
-    };
-
-    auto fourSum = [](float acc, float num) -> float {
-        return acc + (num * num * num * num);
-    };
-
-    float sx = std::accumulate(xs.begin(), xs.end(), 0.0f);
-    float sxx = std::accumulate(xs.begin(), xs.end(), 0.0f, squareSum);
-    float sxxx = std::accumulate(xs.begin(), xs.end(), 0.0f, cubeSum);
-    float sxxxx = std::accumulate(xs.begin(), xs.end(), 0.0f, fourSum);
+std::pair<float, float> approx_log(const float *ys, const LogColumns &columns) {
+    PROFILE_SCOPE("approx_log");
 
-    float sy = std::accumulate(ys.begin(), ys.end(), 0.0f);
-    float sxy = std::inner_product(xs.begin(), xs.end(), ys.begin(), 0.0f);
-    float sxxy = 0.0f;
-    for (size_t i = 0; i < xs.size(); i++) {
-        sxxy += xs[i] * xs[i] * ys[i];
+    if (!columns.hasLnX()) {
+        throw std::runtime_error("Log approximation needs all x to be positive!");
     }
 
-    size_t n = xs.size();
+    std::pair<float, float> line = regression_line(columns.lnX.data(), ys, columns.n);
 
-    Eigen::Matrix3f A;
-    A << n, sx, sxx,
-            sx, sxx, sxxx,
-            sxx, sxxx, sxxxx;
-
-    Eigen::Vector3f B;
-    B << sy, sxy, sxxy;
+    return {line.second, line.first};
+}
 
-    float detA = A.determinant();
+std::pair<float, float> approx_exponential(const LogMoments &l) {
+    PROFILE_COUNT("solver_calls", 1);
 
-    if (detA == 0) {
-        throw std::runtime_error("The system of equations has no unique solution!");
-    } else {
-        std::cout << "DET = " << detA << std::endl;
+    if (l.nonPositiveY > 0) {
+        throw std::runtime_error("Exponential approximation needs all y to be positive!");
     }
 
-    Eigen::Vector3f a;
-    a = A.colPivHouseholderQr().solve(B);
+    std::pair<float, float> line = linear_regression(l.n, l.sx, l.sxx, l.sly, l.sxly);
 
-    return {
-            a(0), a(1), a(2)
-    };
+    return {std::exp(line.first), line.second};
 }
 
-std::vector<float> cube_approximation(std::vector<float> xs, std::vector<float> ys) {
-    auto squareSum =
-            [](float acc, float num) -> float {
-                return acc + (num * num);
-            };
+std::pair<float, float> approx_power(const LogMoments &l) {
+    PROFILE_COUNT("solver_calls", 1);
 
-    auto cubeSum = [](float acc, float num) -> float {
-        return acc + (num * num * num);
-    };
+    if (l.nonPositiveX > 0 || l.nonPositiveY > 0) {
+        throw std::runtime_error("Power approximation needs all x and y to be positive!");
+    }
 
-    auto fourSum = [](float acc, float num) -> float {
-        return acc + (num * num * num * num);
-    };
+    std::pair<float, float> line = linear_regression(l.n, l.slx, l.slxlx, l.sly, l.slxly);
 
-    auto fiveSum = [](float acc, float num) -> float {
-        return acc + (num * num * num * num * num);
-    };
+    return {std::exp(line.first), line.second};
+}
+
+std::pair<float, float> approx_log(const LogMoments &l) {
+    PROFILE_COUNT("solver_calls", 1);
 
-    float sx = std::accumulate(xs.begin(), xs.end(), 0.0f);
-    float sxx = std::accumulate(xs.begin(), xs.end(), 0.0f, squareSum);
-    float sxxx = std::accumulate(xs.begin(), xs.end(), 0.0f, cubeSum);
-    float sxxxx = std::accumulate(xs.begin(), xs.end(), 0.0f, fourSum);
-    float sxxxxx = std::accumulate(xs.begin(), xs.end(), 0.0f, fiveSum);
-
-    float sy = std::accumulate(ys.begin(), ys.end(), 0.0f);
-    float sxy = std::inner_product(xs.begin(), xs.end(), ys.begin(), 0.0f);
-    float sxxy = 0.0f;
-    float sxxxy = 0.0f;
-    for (size_t i = 0; i < xs.size(); i++) {
-        sxxy += xs[i] * xs[i] * ys[i];
-        sxxxy += xs[i] * xs[i] * xs[i] * ys[i];
+    if (l.nonPositiveX > 0) {
+        throw std::runtime_error("Log approximation needs all x to be positive!");
     }
 
-    size_t n = xs.size();
+    std::pair<float, float> line = linear_regression(l.n, l.slx, l.slxlx, l.sy, l.slxy);
 
-    Eigen::Matrix4f A;
-    A << n, sx, sxx, sxxx,
-            sx, sxx, sxxx, sxxxx,
-            sxx, sxxx, sxxxx, sxxxxx,
-            sxxx, sxxxx, sxxxxx, sxxxy;
+    return {line.second, line.first};
+}
+
+/*
+ * return value contains 3 float coefficients of t
+ *
+ * PolyFit::try_solve accepts only a positive definite normal system, so the solution is the minimum of S
+ */
+Polynomial quadratic_approximation(const std::vector<float> &xs, const std::vector<float> &ys) {
+    return PolyFit<2>::polynomial(xs, ys);
+}
 
-    Eigen::Vector4f B;
-    B << sy, sxy, sxxy, sxxxy;
+Polynomial quadratic_approximation(const float *xs, const float *ys, size_t n) {
+    return PolyFit<2>::polynomial(xs, ys, n);
+}
 
-    float detA = A.determinant();
+Polynomial quadratic_approximation(const Moments &m) {
+    PROFILE_SCOPE("quadratic_approximation");
+    return PolyFit<2>::polynomial(m);
+}
 
-    if (detA == 0) {
-        throw std::runtime_error("The system of equations has no unique solution!");
-    }
+Polynomial cube_approximation(const std::vector<float> &xs, const std::vector<float> &ys) {
+    return PolyFit<3>::polynomial(xs, ys);
+}
 
-    Eigen::Vector4f a;
-    a = A.colPivHouseholderQr().solve(B);
+Polynomial cube_approximation(const float *xs, const float *ys, size_t n) {
+    return PolyFit<3>::polynomial(xs, ys, n);
+}
 
-    return {
-            a(0), a(1), a(2), a(3)
-    };
-}
\ No newline at end of file
+Polynomial cube_approximation(const Moments &m) {
+    PROFILE_SCOPE("cube_approximation");
+    return PolyFit<3>::polynomial(m);
+}
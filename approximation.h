@@ -5,49 +5,67 @@
 #include <numeric>
 #include <valarray>
 #include <stdexcept>
-<<<<<<< HEAD
 #include <iostream>
+#include <algorithm>
 
 #include "/home/cleanyco/Downloads/eigen-3.4.0/Eigen/Core"
 #include "/home/cleanyco/Downloads/eigen-3.4.0/Eigen/Dense"
 
-std::pair<float, float> approx_lineal(std::vector<float> xs, std::vector<float> ys);
+#include "log_columns.h"
+#include "moments.h"
+#include "polyfit.h"
 
-std::vector<float> quadratic_approximation(std::vector<float> xs, std::vector<float> ys);
+std::pair<float, float> approx_lineal(const std::vector<float> &xs, const std::vector<float> &ys);
 
-std::vector<float> cube_approximation(std::vector<float> xs, std::vector<float> ys);
+std::pair<float, float> approx_lineal(const float *xs, const float *ys, size_t n);
 
-std::pair<float, float> approx_exponential(std::vector<float> &xs, std::vector<float> &ys);
-
-std::pair<float, float> approx_power(std::vector<float> &xs, std::vector<float> &ys);
+std::pair<float, float> approx_lineal(const Moments &m);
 
-std::pair<float, float> approx_log(std::vector<float> &xs, std::vector<float> &ys);
+/*
+ * approx_lineal without the exception, for callers that fit many series: false if the normal system has
+ * no reliable unique solution (see PolyFit::try_solve) or the line is not a minimum of S
+ */
+bool try_lineal(const Moments &m, std::pair<float, float> &line);
 
-=======
+/* the quadratic and cube fits are solved in t (see Polynomial), centered on the data or in the scaling of the moments */
+Polynomial quadratic_approximation(const std::vector<float> &xs, const std::vector<float> &ys);
 
-std::pair<float, float> approx_lineal(std::vector<float> xs, std::vector<float> ys);
+Polynomial quadratic_approximation(const float *xs, const float *ys, size_t n);
 
-float deviation_lineal(float a, float b, std::vector<float> &xs, std::vector<float> &ys);
+Polynomial quadratic_approximation(const Moments &m);
 
+Polynomial cube_approximation(const std::vector<float> &xs, const std::vector<float> &ys);
 
-float standard_deviation(float S, size_t n);
+Polynomial cube_approximation(const float *xs, const float *ys, size_t n);
 
-float correlation_coefficient(std::vector<float> xs, std::vector<float> ys);
+Polynomial cube_approximation(const Moments &m);
 
+/* least squares line v = A + B * u from its sums n, Σu, Σu^2, Σv, Σu*v, solved in double; returns {A, B} */
+std::pair<float, float> linear_regression(double n, double su, double suu, double sv, double suv);
 
 std::pair<float, float> approx_exponential(std::vector<float> &xs, std::vector<float> &ys);
 
-float deviation_exponential(float a, float b, std::vector<float> &xs, std::vector<float> &ys);
+std::pair<float, float> approx_exponential(const float *xs, const float *ys, size_t n);
 
+std::pair<float, float> approx_exponential(const LogMoments &l);
+
+/* the linearized fits on logarithms taken once for the data set (see log_columns.h) */
+std::pair<float, float> approx_exponential(const float *xs, const LogColumns &columns);
 
 std::pair<float, float> approx_power(std::vector<float> &xs, std::vector<float> &ys);
 
-float deviation_power(float a, float b, std::vector<float> &xs, std::vector<float> &ys);
+std::pair<float, float> approx_power(const float *xs, const float *ys, size_t n);
+
+std::pair<float, float> approx_power(const LogMoments &l);
 
+std::pair<float, float> approx_power(const LogColumns &columns);
 
 std::pair<float, float> approx_log(std::vector<float> &xs, std::vector<float> &ys);
 
-float deviation_log(float a, float b, std::vector<float> &xs, std::vector<float> &ys);
+std::pair<float, float> approx_log(const float *xs, const float *ys, size_t n);
+
+std::pair<float, float> approx_log(const LogMoments &l);
+
+std::pair<float, float> approx_log(const float *ys, const LogColumns &columns);
 
->>>>>>> 14a64c6ca021cf574de1c7c89d39f8eca1b3870f
 #endif //FUNCTION_APPROXIMATION_APPROXIMATION_H
@@ -0,0 +1,304 @@
+#include "batch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+
+#include "batch_kernels.h"
+#include "polyfit.h"
+#include "process.h"
+#include "scoring.h"
+#include "thread_pool.h"
+#include "util.h"
+
+namespace {
+    /* series handed to a thread at once, big enough to amortize the task, small enough to balance */
+    const size_t SERIES_PER_TASK = 256;
+
+    /* longer series vectorize well on their own, shorter ones are fitted side by side in lanes */
+    const size_t LANE_SERIES_MAX_POINTS = 256;
+
+    const Model ALL_MODELS[] = {Model::Lineal, Model::Quadratic, Model::Qube, Model::Power, Model::Exp, Model::Log};
+
+    /*
+     * coefficients already found for the whole task (lineal and quadratic by the lane solves, the cube
+     * by one batched solve), no coefficients for a failed fit; the rest is fitted one series at a time
+     */
+    struct KnownFits {
+        std::optional<FitResult> lineal;
+        std::optional<FitResult> quadratic;
+        std::optional<FitResult> qube;
+    };
+
+    /* nan, inf and -inf are all written as nan, the same as the quiet mode CSV does */
+    void appendNumber(std::string &record, float value) {
+        if (!std::isfinite(value)) {
+            record += "nan";
+            return;
+        }
+
+        char buffer[32];
+        int length = std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        record.append(buffer, static_cast<size_t>(length));
+    }
+
+    /* the x and y of the series do not match, nothing was fitted */
+    void appendFailedRecord(std::string &records, const Series &series) {
+        records += series.name;
+        records += ',';
+        records += std::to_string(series.size());
+        records += ",none,nan";
+        for (size_t i = 0; i < std::size(ALL_MODELS); i++) {
+            records += ",nan";
+        }
+        records += '\n';
+    }
+
+    void appendRecord(std::string &records, const Series &series, const Moments &moments,
+                      const KnownFits &known, bool refine) {
+        const float *xs = series.xs();
+        const float *ys = series.ys();
+        size_t n = series.size();
+
+        std::vector<Model> models = candidateModels(hasNegativeNumber(xs, n), hasNegativeNumber(ys, n));
+
+        /* power, exp and log share the logarithms of the series */
+        LogColumns logs = compute_log_columns(xs, ys, n);
+
+        /* a model whose fit fails (no unique solution, no minimum) simply drops out of the competition */
+        std::optional<float> deviations[std::size(ALL_MODELS)];
+
+        /* the models not known yet are fitted here, then every candidate is scored by one pass over the series */
+        std::vector<FitResult> fits;
+        for (Model model : models) {
+            FitResult fit;
+            fit.model = model;
+            if (model == Model::Lineal && known.lineal) {
+                fit = *known.lineal;
+            } else if (model == Model::Quadratic && known.quadratic) {
+                fit = *known.quadratic;
+            } else if (model == Model::Qube && known.qube) {
+                fit = *known.qube;
+            } else {
+                try {
+                    fit = fit_coefficients(model, xs, ys, n, moments, logs, refine);
+                } catch (const std::exception &) {
+                }
+            }
+            fits.push_back(std::move(fit));
+        }
+
+        score_fits(fits, xs, ys, n, logs, moments, false);
+        for (const FitResult &fit : fits) {
+            deviations[static_cast<size_t>(fit.model)] = fit.standardDeviation;
+        }
+
+        const char *best = "none";
+        float bestDeviation = std::numeric_limits<float>::quiet_NaN();
+
+        /* in the order of models, so ties go to the same model as before */
+        for (Model model : models) {
+            float deviation = *deviations[static_cast<size_t>(model)];
+            if (!std::isnan(deviation) && (std::isnan(bestDeviation) || deviation < bestDeviation)) {
+                bestDeviation = deviation;
+                best = modelName(model);
+            }
+        }
+
+        records += series.name;
+        records += ',';
+        records += std::to_string(n);
+        records += ',';
+        records += best;
+        records += ',';
+        appendNumber(records, bestDeviation);
+
+        for (const std::optional<float> &deviation : deviations) {
+            records += ',';
+            if (deviation) {
+                appendNumber(records, *deviation);
+            }
+        }
+
+        records += '\n';
+    }
+
+    std::string recordsOf(const std::vector<Series> &series, size_t begin, size_t end, bool refine) {
+        std::string records;
+        records.reserve((end - begin) * 96);
+
+        /* lineal and quadratic are candidates for every series, so short ones get both from the lanes */
+        std::vector<KnownFits> known(end - begin);
+
+        SeriesLanes packed;
+        LaneFits fits;
+        const float *groupXs[SERIES_LANES];
+        const float *groupYs[SERIES_LANES];
+        size_t groupN[SERIES_LANES];
+        size_t indices[SERIES_LANES];
+        size_t count = 0;
+
+        for (size_t i = begin; i <= end; i++) {
+            if (i < end) {
+                const Series &one = series[i];
+                if (one.matched() && one.size() <= LANE_SERIES_MAX_POINTS) {
+                    groupXs[count] = one.xs();
+                    groupYs[count] = one.ys();
+                    groupN[count] = one.size();
+                    indices[count] = i - begin;
+                    count++;
+                }
+            }
+
+            if (count == SERIES_LANES || (i == end && count > 0)) {
+                pack_series(groupXs, groupYs, groupN, count, packed);
+                solve_lanes(packed, fits);
+
+                for (size_t l = 0; l < count; l++) {
+                    KnownFits &solvedFits = known[indices[l]];
+                    solvedFits.lineal = FitResult{Model::Lineal, {}, {}};
+                    solvedFits.quadratic = FitResult{Model::Quadratic, {}, packed.scaling[l]};
+                    if (fits.linealSolved[l]) {
+                        solvedFits.lineal->coefficients = {fits.a[l], fits.b[l]};
+                    }
+                    if (fits.quadraticSolved[l]) {
+                        solvedFits.quadratic->coefficients = {fits.a_0[l], fits.a_1[l], fits.a_2[l]};
+                    }
+                }
+
+                count = 0;
+            }
+        }
+
+        /* the cube is a candidate for every series as well, its small systems are solved all at once */
+        std::vector<Moments> moments(end - begin);
+        std::vector<PolyFit<3>::PowerSums> sums(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            const Series &one = series[i];
+            if (!one.matched()) {
+                /* empty sums, the solve of the cube refuses them */
+                continue;
+            }
+
+            moments[i - begin] = compute_moments(one.xs(), one.ys(), one.size(), 3);
+            sums[i - begin] = PolyFit<3>::power_sums(moments[i - begin]);
+        }
+
+        std::vector<PolyFit<3>::Vector> cubes(end - begin);
+        std::unique_ptr<bool[]> solved(new bool[end - begin]);
+        PolyFit<3>::solve_all(sums.data(), sums.size(), cubes.data(), solved.get());
+
+        for (size_t j = 0; j < end - begin; j++) {
+            known[j].qube = FitResult{Model::Qube, {}, moments[j].scaling};
+            if (solved[j]) {
+                known[j].qube->coefficients = PolyFit<3>::coefficients(cubes[j]);
+            }
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            if (series[i].matched()) {
+                appendRecord(records, series[i], moments[i - begin], known[i - begin], refine);
+            } else {
+                appendFailedRecord(records, series[i]);
+            }
+        }
+
+        return records;
+    }
+}
+
+std::vector<Series> readSeriesFile(const std::string &fileName) {
+    std::vector<FunctionPoints> all = readMultiSeriesFromFile(fileName);
+
+    std::vector<Series> series;
+    series.reserve(all.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        series.push_back({std::to_string(i + 1), std::move(all[i]), nullptr});
+    }
+
+    return series;
+}
+
+std::vector<Series> readManifest(const std::string &fileName) {
+    std::ifstream manifest(fileName);
+    if (!manifest.is_open()) {
+        throw std::runtime_error("Cannot open the manifest!");
+    }
+
+    std::vector<Series> series;
+    std::string path;
+    while (std::getline(manifest, path)) {
+        if (!path.empty() && path.back() == '\r') {
+            path.pop_back();
+        }
+        if (path.empty()) {
+            continue;
+        }
+
+        /* binary files stay mapped for the run and are fitted in place, text files are parsed */
+        if (isBinaryPointsFile(path)) {
+            series.push_back({path, {}, std::make_shared<const MappedPoints>(path)});
+        } else {
+            series.push_back({path, readFunctionPointsFromFile(path), nullptr});
+        }
+    }
+
+    return series;
+}
+
+BatchSummary runBatch(const std::vector<Series> &series, std::ostream &out, size_t threads, bool refine) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    out << "series,n,best,best_sd";
+    for (Model model : ALL_MODELS) {
+        out << ",sd_" << modelName(model);
+    }
+    out << '\n';
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    size_t tasks = (series.size() + SERIES_PER_TASK - 1) / SERIES_PER_TASK;
+
+    if (threads == 1 || tasks <= 1) {
+        for (size_t begin = 0; begin < series.size(); begin += SERIES_PER_TASK) {
+            std::string records = recordsOf(series, begin, std::min(series.size(), begin + SERIES_PER_TASK), refine);
+            out.write(records.data(), static_cast<std::streamsize>(records.size()));
+        }
+    } else {
+        ThreadPool pool(std::min(threads, tasks));
+
+        std::vector<std::future<std::string>> blocks;
+        blocks.reserve(tasks);
+        for (size_t begin = 0; begin < series.size(); begin += SERIES_PER_TASK) {
+            size_t end = std::min(series.size(), begin + SERIES_PER_TASK);
+            blocks.push_back(pool.submit([&series, begin, end, refine]() {
+                return recordsOf(series, begin, end, refine);
+            }));
+        }
+
+        /* blocks are written in order, so the records follow the series whatever thread made them */
+        for (std::future<std::string> &block : blocks) {
+            std::string records = block.get();
+            out.write(records.data(), static_cast<std::streamsize>(records.size()));
+        }
+    }
+
+    out.flush();
+
+    BatchSummary summary;
+    summary.series = series.size();
+    for (const Series &s : series) {
+        summary.points += s.size();
+    }
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return summary;
+}
@@ -0,0 +1,63 @@
+#ifndef FUNCTION_APPROXIMATION_BATCH_H
+#define FUNCTION_APPROXIMATION_BATCH_H
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "points_file.h"
+
+/*
+ * the points of a text series are read into points; a binary file of a manifest is mapped instead
+ * and fitted in place, xs() and ys() point into whichever of the two holds the series
+ */
+struct Series {
+    std::string name;
+    FunctionPoints points;
+    std::shared_ptr<const MappedPoints> mapped;
+
+    const float *xs() const {
+        return mapped ? mapped->xs() : points.first.data();
+    }
+
+    const float *ys() const {
+        return mapped ? mapped->ys() : points.second.data();
+    }
+
+    size_t size() const {
+        return mapped ? mapped->size() : points.first.size();
+    }
+
+    /* false if the lines of xs and ys of a text series differ in length */
+    bool matched() const {
+        return mapped || points.first.size() == points.second.size();
+    }
+};
+
+struct BatchSummary {
+    size_t series = 0;
+    size_t points = 0;
+    double seconds = 0;
+};
+
+/* every series of a multi-series text file, named by their number starting from 1 */
+std::vector<Series> readSeriesFile(const std::string &fileName);
+
+/* a manifest lists one points file (text or binary) per line, the series are named by their paths */
+std::vector<Series> readManifest(const std::string &fileName);
+
+/*
+ * runs the model competition for every series without the per point report:
+ * one CSV record per series is written to out, in the order of the series, with the best model
+ * and the standard deviation of every model (empty if the model is not a candidate for the series,
+ * nan if its fit failed). All the fitted models of a series are scored together by score_fits, as in
+ * the quiet mode of a single series; the polynomial fits S of which the moments give skip the pass,
+ * their max error is not written. A series whose lines of x and y differ in length gets a record with no best
+ * model and nan for every model, the other series go on. Series are spread over threads (0 picks one per core).
+ * With refine the power and exp fits of every series are refined as in fit_model.
+ */
+BatchSummary runBatch(const std::vector<Series> &series, std::ostream &out, size_t threads = 0,
+                      bool refine = false);
+
+#endif //FUNCTION_APPROXIMATION_BATCH_H
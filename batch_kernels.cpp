@@ -0,0 +1,299 @@
+#include "batch_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "simd.h"
+
+using namespace simd;
+
+static_assert(SERIES_LANES % WIDTH == 0, "series lanes must fill whole vectors");
+
+namespace {
+    constexpr size_t GROUPS = SERIES_LANES / WIDTH;
+
+    /* stores vector v of group g into the per lane array */
+    inline void storeLanes(float *lanes, size_t g, Vec v) {
+        store(lanes + g * WIDTH, v);
+    }
+
+    inline Vec loadLanes(const float *lanes, size_t g) {
+        return load(lanes + g * WIDTH);
+    }
+}
+
+void pack_series(const FunctionPoints *const *series, size_t count, SeriesLanes &lanes) {
+    if (count > SERIES_LANES) {
+        throw std::runtime_error("Too many series for one batch of lanes!");
+    }
+
+    const float *xs[SERIES_LANES];
+    const float *ys[SERIES_LANES];
+    size_t n[SERIES_LANES];
+
+    for (size_t l = 0; l < count; l++) {
+        if (series[l]->first.size() != series[l]->second.size()) {
+            throw std::runtime_error("The number of points x and y don't match!");
+        }
+
+        xs[l] = series[l]->first.data();
+        ys[l] = series[l]->second.data();
+        n[l] = series[l]->first.size();
+    }
+
+    pack_series(xs, ys, n, count, lanes);
+}
+
+void pack_series(const float *const *xs, const float *const *ys, const size_t *n, size_t count, SeriesLanes &lanes) {
+    if (count > SERIES_LANES) {
+        throw std::runtime_error("Too many series for one batch of lanes!");
+    }
+
+    lanes.lanes = count;
+    lanes.length = 0;
+    for (size_t l = 0; l < SERIES_LANES; l++) {
+        lanes.n[l] = l < count ? n[l] : 0;
+        lanes.scaling[l] = l < count ? centered_scaling(xs[l], n[l]) : XScaling();
+        lanes.length = std::max(lanes.length, lanes.n[l]);
+    }
+
+    size_t size = lanes.length * SERIES_LANES;
+    lanes.xs.assign(size, 0.0f);
+    lanes.ys.assign(size, 0.0f);
+    lanes.mask.assign(size, 0.0f);
+
+    for (size_t l = 0; l < count; l++) {
+        for (size_t i = 0; i < n[l]; i++) {
+            lanes.xs[i * SERIES_LANES + l] = xs[l][i];
+            lanes.ys[i * SERIES_LANES + l] = ys[l][i];
+            lanes.mask[i * SERIES_LANES + l] = 1.0f;
+        }
+    }
+}
+
+namespace {
+    /* the center and 1 / scale of every lane as floats, t = (x - center) * inverse */
+    void laneScaling(const SeriesLanes &lanes, float *center, float *inverse) {
+        for (size_t l = 0; l < SERIES_LANES; l++) {
+            center[l] = static_cast<float>(lanes.scaling[l].center);
+            inverse[l] = lanes.scaling[l].inverse();
+        }
+    }
+}
+
+namespace {
+    /* lane by lane: finite(v) is false for inf and NaN, whose v - v is NaN */
+    inline Mask finite(Vec v) {
+        return equal(sub(v, v), set1(0));
+    }
+
+    inline Vec absolute(Vec v) {
+        return max(v, sub(set1(0), v));
+    }
+
+    inline void storeSolved(bool *solved, size_t g, Mask ok) {
+        float lanes[WIDTH];
+        store(lanes, select(ok, set1(1), set1(0)));
+        for (size_t l = 0; l < WIDTH; l++) {
+            solved[g * WIDTH + l] = lanes[l] != 0;
+        }
+    }
+
+    /*
+     * LDLT of the equilibrated normal systems of WIDTH lanes, E = D * A * D with D = diag(1 / sqrt(A[j][j])):
+     * E = L * diag(1, d1, d2) * L^T, L = [1 0 0; e01 1 0; e02 l21 1]. The lineal system is the leading 2x2
+     */
+    struct LaneLdlt {
+        Vec D0, D1, D2;
+        Vec e01, e02, e12;
+        Vec l21, d1, d2;
+
+        LaneLdlt(Vec a00, Vec a01, Vec a02, Vec a11, Vec a12, Vec a22) {
+            const Vec one = set1(1);
+
+            D0 = div(one, sqrt(a00));
+            D1 = div(one, sqrt(a11));
+            D2 = div(one, sqrt(a22));
+
+            e01 = mul(mul(a01, D0), D1);
+            e02 = mul(mul(a02, D0), D2);
+            e12 = mul(mul(a12, D1), D2);
+
+            d1 = fnmadd(e01, e01, one);
+            l21 = div(fnmadd(e02, e01, e12), d1);
+            d2 = fnmadd(mul(l21, l21), d1, fnmadd(e02, e02, one));
+        }
+
+        /* A * (b, a) = (B0, B1) */
+        void solve(Vec B0, Vec B1, Vec &b, Vec &a) const {
+            Vec z0 = mul(D0, B0);
+            Vec z1 = fnmadd(e01, z0, mul(D1, B1));
+
+            Vec v1 = div(z1, d1);
+            a = mul(D1, v1);
+            b = mul(D0, fnmadd(e01, v1, z0));
+        }
+
+        /* A * (q0, q1, q2) = (B0, B1, B2) */
+        void solve(Vec B0, Vec B1, Vec B2, Vec &q0, Vec &q1, Vec &q2) const {
+            Vec z0 = mul(D0, B0);
+            Vec z1 = fnmadd(e01, z0, mul(D1, B1));
+            Vec z2 = fnmadd(l21, z1, fnmadd(e02, z0, mul(D2, B2)));
+
+            Vec u2 = div(z2, d2);
+            Vec u1 = fnmadd(l21, u2, div(z1, d1));
+            Vec u0 = fnmadd(e02, u2, fnmadd(e01, u1, z0));
+
+            q0 = mul(D0, u0);
+            q1 = mul(D1, u1);
+            q2 = mul(D2, u2);
+        }
+    };
+}
+
+void solve_lanes(const SeriesLanes &lanes, LaneFits &fits) {
+    float n[SERIES_LANES];
+    for (size_t l = 0; l < SERIES_LANES; l++) {
+        n[l] = static_cast<float>(lanes.n[l]);
+    }
+
+    float center[SERIES_LANES], inverse[SERIES_LANES];
+    laneScaling(lanes, center, inverse);
+
+    const Vec zero = set1(0), one = set1(1);
+    const Vec epsilon = set1(std::numeric_limits<float>::epsilon());
+
+    for (size_t g = 0; g < GROUPS; g++) {
+        /* moments Σt^k (k = 1..4) and Σt^k * y (k = 0..2) of every lane, Σt^0 is the length of the series */
+        Vec S1 = zero, S2 = zero, S3 = zero, S4 = zero;
+        Vec T0 = zero, T1 = zero, T2 = zero;
+        Vec C = loadLanes(center, g), INV = loadLanes(inverse, g);
+
+        for (size_t i = 0; i < lanes.length; i++) {
+            size_t offset = i * SERIES_LANES + g * WIDTH;
+            /* t of the padding is not 0, the mask takes it out of the sums */
+            Vec x = mul(mul(sub(load(lanes.xs.data() + offset), C), INV), load(lanes.mask.data() + offset));
+            Vec y = load(lanes.ys.data() + offset);
+            Vec xx = mul(x, x);
+
+            S1 = add(S1, x);
+            S2 = add(S2, xx);
+            S3 = fmadd(xx, x, S3);
+            S4 = fmadd(xx, xx, S4);
+            T0 = add(T0, y);
+            T1 = fmadd(x, y, T1);
+            T2 = fmadd(xx, y, T2);
+        }
+
+        /*
+         * The normal systems of all the lanes at once, A = [n S1 S2; S1 S2 S3; S2 S3 S4], the lineal one is
+         * its leading 2x2. Solved the way PolyFit::try_solve solves a single series: equilibrated to a unit
+         * diagonal by D = diag(1 / sqrt(A[j][j])), factored by LDLT and accepted only if the pivots are
+         * within float ε of each other and the reciprocal condition number is at least ε. Here in float
+         * and without branches, every test is a mask and a lane that fails any of them keeps 0 coefficients.
+         * The 2x2 and 3x3 inverses are the adjugates, so rcond is exact where try_solve has Eigen's estimate.
+         */
+        Vec N = loadLanes(n, g);
+        Mask positive = both(greater(N, zero), both(greater(S2, zero), greater(S4, zero)));
+
+        const LaneLdlt ldlt(select(positive, N, one), S1, S2, select(positive, S2, one), S3,
+                            select(positive, S4, one));
+        const Vec &e01 = ldlt.e01, &e02 = ldlt.e02, &e12 = ldlt.e12, &d1 = ldlt.d1, &d2 = ldlt.d2;
+
+        /*
+         * the factorization in float is off by far more than the double one of try_solve, one step of
+         * iterative refinement (the residual of the normal system solved again) brings the solution back
+         * to the accuracy of the sums
+         */
+        Vec a, b, da, db;
+        ldlt.solve(T0, T1, b, a);
+        ldlt.solve(fnmadd(S1, a, fnmadd(N, b, T0)), fnmadd(S2, a, fnmadd(S1, b, T1)), db, da);
+        a = add(a, da);
+        b = add(b, db);
+
+        /* rcond of [1 e01; e01 1] is (1 - |e01|) / (1 + |e01|) */
+        Vec r01 = absolute(e01);
+        Mask linealOk = both(positive, both(greater(d1, mul(epsilon, max(one, d1))),
+                                            greater(sub(one, r01), mul(epsilon, add(one, r01)))));
+
+        /* taken back to x: a / scale and b - a / scale * center */
+        Vec slope = mul(a, INV);
+        Vec intercept = fnmadd(slope, C, b);
+        linealOk = both(linealOk, both(finite(slope), finite(intercept)));
+
+        storeLanes(fits.a, g, select(linealOk, slope, zero));
+        storeLanes(fits.b, g, select(linealOk, intercept, zero));
+        storeSolved(fits.linealSolved, g, linealOk);
+
+        Vec q0, q1, q2, dq0, dq1, dq2;
+        ldlt.solve(T0, T1, T2, q0, q1, q2);
+        ldlt.solve(fnmadd(S2, q2, fnmadd(S1, q1, fnmadd(N, q0, T0))),
+                   fnmadd(S3, q2, fnmadd(S2, q1, fnmadd(S1, q0, T1))),
+                   fnmadd(S4, q2, fnmadd(S3, q1, fnmadd(S2, q0, T2))), dq0, dq1, dq2);
+        q0 = add(q0, dq0);
+        q1 = add(q1, dq1);
+        q2 = add(q2, dq2);
+
+        /*
+         * rcond = 1 / (||E||_1 * ||E^-1||_1) with E^-1 = adj(E) / det(E) and det(E) = d1 * d2,
+         * so rcond >= ε is det(E) >= ε * ||E||_1 * ||adj(E)||_1
+         */
+        Vec r02 = absolute(e02), r12 = absolute(e12);
+        Vec norm = add(one, max(add(r01, r02), max(add(r01, r12), add(r02, r12))));
+
+        Vec adj00 = absolute(fnmadd(e12, e12, one));
+        Vec adj11 = absolute(fnmadd(e02, e02, one));
+        Vec adj22 = absolute(fnmadd(e01, e01, one));
+        Vec adj01 = absolute(fmadd(e02, e12, sub(zero, e01)));
+        Vec adj02 = absolute(fmadd(e01, e12, sub(zero, e02)));
+        Vec adj12 = absolute(fmadd(e01, e02, sub(zero, e12)));
+        Vec adjNorm = max(add(add(adj00, adj01), adj02), max(add(add(adj01, adj11), adj12),
+                                                             add(add(adj02, adj12), adj22)));
+
+        Vec lowest = min(one, min(d1, d2));
+        Vec highest = max(one, max(d1, d2));
+        Mask quadraticOk = both(positive, both(greater(lowest, mul(epsilon, highest)),
+                                               greater(mul(d1, d2), mul(mul(epsilon, norm), adjNorm))));
+        quadraticOk = both(quadraticOk, both(finite(q0), both(finite(q1), finite(q2))));
+
+        storeLanes(fits.a_0, g, select(quadraticOk, q0, zero));
+        storeLanes(fits.a_1, g, select(quadraticOk, q1, zero));
+        storeLanes(fits.a_2, g, select(quadraticOk, q2, zero));
+        storeSolved(fits.quadraticSolved, g, quadraticOk);
+    }
+}
+
+void fit_lanes(const SeriesLanes &lanes, LaneFits &fits) {
+    solve_lanes(lanes, fits);
+
+    float center[SERIES_LANES], inverse[SERIES_LANES];
+    laneScaling(lanes, center, inverse);
+
+    /* S of both fits, the padding is masked out because φ(0) is not 0 */
+    for (size_t g = 0; g < GROUPS; g++) {
+        Vec A = loadLanes(fits.a, g), B = loadLanes(fits.b, g);
+        Vec A0 = loadLanes(fits.a_0, g), A1 = loadLanes(fits.a_1, g), A2 = loadLanes(fits.a_2, g);
+        Vec C = loadLanes(center, g), INV = loadLanes(inverse, g);
+
+        Vec linealS = set1(0), quadraticS = set1(0);
+
+        for (size_t i = 0; i < lanes.length; i++) {
+            size_t offset = i * SERIES_LANES + g * WIDTH;
+            Vec x = load(lanes.xs.data() + offset);
+            Vec y = load(lanes.ys.data() + offset);
+            Vec m = load(lanes.mask.data() + offset);
+            Vec t = mul(sub(x, C), INV);
+
+            Vec el = mul(sub(fmadd(A, x, B), y), m);
+            Vec eq = mul(sub(fmadd(fmadd(A2, t, A1), t, A0), y), m);
+
+            linealS = fmadd(el, el, linealS);
+            quadraticS = fmadd(eq, eq, quadraticS);
+        }
+
+        storeLanes(fits.linealDeviation, g, linealS);
+        storeLanes(fits.quadraticDeviation, g, quadraticS);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef FUNCTION_APPROXIMATION_BATCH_KERNELS_H
+#define FUNCTION_APPROXIMATION_BATCH_KERNELS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "points_file.h"
+#include "polynomial.h"
+
+/*
+ * Lineal and quadratic fits of many short series at once.
+ *
+ * Inside a series of 10-100 points there is nothing to vectorize, so instead every vector lane
+ * works on its own series: SERIES_LANES series are interleaved point by point (structure of arrays),
+ * one pass accumulates the moments of all of them, the 2x2 and 3x3 normal systems of all the lanes are
+ * solved at once with the tests PolyFit::try_solve applies to a single series, and a second pass measures
+ * the deviations of all of them (or leaves that to the caller, see solve_lanes).
+ */
+constexpr size_t SERIES_LANES = 8;
+
+/*
+ * point i of lane l is xs[i * SERIES_LANES + l];
+ * shorter series are padded with x = y = 0 and mask = 0, so the padding adds nothing to the sums.
+ * scaling[l] is the centered_scaling of series l, its moments are those of t as for a single series
+ */
+struct SeriesLanes {
+    size_t lanes = 0;
+    size_t length = 0;
+    size_t n[SERIES_LANES] = {};
+    XScaling scaling[SERIES_LANES];
+
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> mask;
+};
+
+struct LaneFits {
+    /* φ(x) = a * x + b */
+    float a[SERIES_LANES];
+    float b[SERIES_LANES];
+    float linealDeviation[SERIES_LANES];
+    bool linealSolved[SERIES_LANES];
+
+    /* φ(x) = a_0 + a_1 * t + a_2 * t^2, t in the scaling of the lane */
+    float a_0[SERIES_LANES];
+    float a_1[SERIES_LANES];
+    float a_2[SERIES_LANES];
+    float quadraticDeviation[SERIES_LANES];
+    bool quadraticSolved[SERIES_LANES];
+};
+
+/* interleaves up to SERIES_LANES series into lanes, the buffers of lanes are reused between calls */
+void pack_series(const FunctionPoints *const *series, size_t count, SeriesLanes &lanes);
+
+/* the same for series given as columns, series l is n[l] points at xs[l] and ys[l] (a mapped file, say) */
+void pack_series(const float *const *xs, const float *const *ys, const size_t *n, size_t count, SeriesLanes &lanes);
+
+/* fits both models for every lane, the deviations of fits are left as they were */
+void solve_lanes(const SeriesLanes &lanes, LaneFits &fits);
+
+/* fits both models for every lane and measures S = Σ(φ(x_i) - y_i)^2 of each fit */
+void fit_lanes(const SeriesLanes &lanes, LaneFits &fits);
+
+#endif //FUNCTION_APPROXIMATION_BATCH_KERNELS_H
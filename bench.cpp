@@ -0,0 +1,1187 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "approximation.h"
+#include "batch_kernels.h"
+#include "cross_validation.h"
+#include "deviation.h"
+#include "diagnostics.h"
+#include "kernels.h"
+#include "online.h"
+#include "points_file.h"
+#include "refine.h"
+#include "scoring.h"
+#include "summation.h"
+#include "table.h"
+#include "vecmath.h"
+#include "window.h"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /* y = 2x + 1 with gaussian noise, x uniform in [0, 10) */
+    void linearSeries(size_t n, std::vector<float> &xs, std::vector<float> &ys) {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> x(0.0f, 10.0f);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+
+        xs.resize(n);
+        ys.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            xs[i] = x(gen);
+            ys[i] = 2 * xs[i] + 1 + noise(gen);
+        }
+    }
+
+    /* a data shape of the suite: x uniform in [1, 10), so every model can be fitted */
+    struct Shape {
+        const char *name;
+        std::function<float(float x, float noise, float uniform)> y;
+    };
+
+    const Shape SHAPES[] = {
+            {"linear",      [](float x, float noise, float) { return std::max(0.01f, 2 * x + 1 + noise); }},
+            {"quadratic",   [](float x, float noise, float) { return 0.5f * x * x - x + 3 + noise; }},
+            {"exponential", [](float x, float noise, float) { return 2 * std::exp(0.3f * x) * (1 + 0.05f * noise); }},
+            {"noise",       [](float, float, float uniform) { return uniform; }},
+    };
+
+    void shapeSeries(const Shape &shape, size_t n, std::vector<float> &xs, std::vector<float> &ys) {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> uniform(1.0f, 10.0f);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+
+        xs.resize(n);
+        ys.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            xs[i] = uniform(gen);
+            ys[i] = shape.y(xs[i], noise(gen), uniform(gen));
+        }
+    }
+
+    /* counts what printTable writes and throws it away, so only the formatting is timed */
+    class CountingBuffer : public std::streambuf {
+    public:
+        size_t count = 0;
+
+    protected:
+        int_type overflow(int_type c) override {
+            count++;
+            return c;
+        }
+
+        std::streamsize xsputn(const char *, std::streamsize n) override {
+            count += static_cast<size_t>(n);
+            return n;
+        }
+    };
+
+    struct SuiteCase {
+        const char *name;
+        /* runs the function once and returns something derived from its result, so it is not optimized out */
+        std::function<float()> run;
+        /* bytes read and written by one run */
+        double bytes;
+    };
+
+    struct SuiteResult {
+        std::string name;
+        const char *shape;
+        size_t n;
+        size_t reps;
+        double nsPerCall;
+        double bytes;
+    };
+
+    /* repeats the case for at least minSeconds and keeps the fastest run */
+    SuiteResult timeCase(const SuiteCase &c, const char *shape, size_t n, float &sink) {
+        const double minSeconds = 0.05;
+
+        SuiteResult result{c.name, shape, n, 0, 0, c.bytes};
+        double best = 0;
+        double total = 0;
+
+        while (result.reps == 0 || total < minSeconds) {
+            Clock::time_point start = Clock::now();
+            sink += c.run();
+            double seconds = secondsSince(start);
+
+            total += seconds;
+            best = result.reps == 0 ? seconds : std::min(best, seconds);
+            result.reps++;
+        }
+
+        result.nsPerCall = best * 1e9;
+        return result;
+    }
+
+    /* printTable keeps every cell as a string, so the table sweeps stop well below the numeric functions */
+    const size_t SUITE_TABLE_MAX_ROWS = 1000000;
+
+    /*
+     * every approx_* and deviation_* function, correlation_coefficient, printTable and TableWriter
+     * for n = 10, 100, ... maxSize and every shape; the results go to jsonFile
+     */
+    void benchSuite(size_t maxSize, const std::string &jsonFile) {
+        std::vector<SuiteResult> results;
+        float sink = 0;
+
+        for (size_t n = 10; n <= maxSize; n *= 10) {
+            for (const Shape &shape : SHAPES) {
+                std::vector<float> xs, ys;
+                shapeSeries(shape, n, xs, ys);
+
+                /* coefficients for the deviations, fitted once outside of the timing */
+                std::pair<float, float> lineal = approx_lineal(xs, ys);
+                Polynomial quadraticFit = quadratic_approximation(xs, ys);
+                Polynomial qubeFit = cube_approximation(xs, ys);
+                /* the deviation_* functions take the coefficients of x */
+                std::vector<float> quadratic = expanded(quadraticFit);
+                std::vector<float> qube = expanded(qubeFit);
+                std::pair<float, float> exponential = approx_exponential(xs, ys);
+                std::pair<float, float> power = approx_power(xs, ys);
+                std::pair<float, float> log = approx_log(xs, ys);
+
+                LogColumns logs = compute_log_columns(xs, ys);
+                std::vector<FitResult> fits = {
+                        {Model::Lineal, {lineal.first, lineal.second}},
+                        {Model::Quadratic, quadraticFit.coefficients, quadraticFit.scaling},
+                        {Model::Qube, qubeFit.coefficients, qubeFit.scaling},
+                        {Model::Power, {power.first, power.second}},
+                        {Model::Exp, {exponential.first, exponential.second}},
+                        {Model::Log, {log.first, log.second}}
+                };
+
+                double points = 2.0 * sizeof(float) * n;
+
+                std::vector<SuiteCase> cases = {
+                        {"approx_lineal",           [&] { return approx_lineal(xs, ys).first; },               points},
+                        {"quadratic_approximation", [&] { return quadratic_approximation(xs, ys).coefficients[0]; }, points},
+                        {"cube_approximation",      [&] { return cube_approximation(xs, ys).coefficients[0]; },  points},
+                        {"approx_exponential",      [&] { return approx_exponential(xs, ys).first; },          points},
+                        {"approx_power",            [&] { return approx_power(xs, ys).first; },                points},
+                        {"approx_log",              [&] { return approx_log(xs, ys).first; },                  points},
+                        {"deviation_lineal",        [&] { return deviation_lineal(lineal.first, lineal.second, xs, ys); }, points},
+                        {"deviation_quadratic",     [&] {
+                            return deviation_quadratic(quadratic[0], quadratic[1], quadratic[2], xs, ys);
+                        }, points},
+                        {"deviation_qube",          [&] {
+                            return deviation_qube(qube[0], qube[1], qube[2], qube[3], xs, ys);
+                        }, points},
+                        {"deviation_polynomial",    [&] { return deviation_polynomial(qubeFit, xs, ys); },     points},
+                        {"deviation_exponential",   [&] {
+                            return deviation_exponential(exponential.first, exponential.second, xs, ys);
+                        }, points},
+                        {"deviation_power",         [&] { return deviation_power(power.first, power.second, xs, ys); }, points},
+                        {"deviation_log",           [&] { return deviation_log(log.first, log.second, xs, ys); }, points},
+                        {"correlation_coefficient", [&] { return correlation_coefficient(xs, ys); },           points},
+                        /* the same r and the R² of the polynomial fits, from moments taken once */
+                        {"moment_diagnostics",      [&] {
+                            Moments moments = compute_moments(xs, ys, 3);
+                            float sum = correlation_coefficient(moments);
+                            for (size_t f = 0; f < 3; f++) {
+                                sum += diagnose(polynomial_sse(fits[f], moments), fits[f].coefficients.size(),
+                                                moments).rSquared;
+                            }
+                            return sum;
+                        }, points},
+                        {"compute_log_columns",     [&] { return float(compute_log_columns(xs, ys).lnX.size()); }, points},
+                        /* power, exp and log fitted and measured, each taking its own logarithms or sharing them */
+                        {"log_fits_separate",       [&] {
+                            std::pair<float, float> e = approx_exponential(xs, ys);
+                            std::pair<float, float> p = approx_power(xs, ys);
+                            std::pair<float, float> l = approx_log(xs, ys);
+                            return deviation_exponential(e.first, e.second, xs, ys)
+                                   + deviation_power(p.first, p.second, xs, ys)
+                                   + deviation_log(l.first, l.second, xs, ys);
+                        }, points},
+                        /* every model scored for the choice of the best one, a pass per model or all in one */
+                        {"score_separate",          [&] {
+                            std::array<float, 2> line = {lineal.second, lineal.first};
+                            return sse_polynomial(line.data(), 1, xs.data(), ys.data(), n)
+                                   + sse_polynomial(quadraticFit.coefficients.data(), 2,
+                                                    static_cast<float>(quadraticFit.scaling.center),
+                                                    quadraticFit.scaling.inverse(), xs.data(), ys.data(), n)
+                                   + sse_polynomial(qubeFit.coefficients.data(), 3,
+                                                    static_cast<float>(qubeFit.scaling.center),
+                                                    qubeFit.scaling.inverse(), xs.data(), ys.data(), n)
+                                   + sse_power_ln(power.first, power.second, logs.lnX.data(), ys.data(), n)
+                                   + sse_exponential(exponential.first, exponential.second, xs.data(), ys.data(), n)
+                                   + sse_log_ln(log.first, log.second, logs.lnX.data(), ys.data(), n);
+                        }, points},
+                        {"score_fused",             [&] {
+                            score_fits(fits, xs.data(), ys.data(), n, logs);
+                            return fits.back().deviation;
+                        }, points},
+                        /* 10-fold cross-validation of the polynomial fits, a refit per fold or from fold moments */
+                        {"cv_refits",               [&] {
+                            const size_t folds = 10;
+                            XScaling scaling = centered_scaling(xs.data(), n);
+                            float S = 0;
+                            for (size_t f = 0; f < folds; f++) {
+                                Moments train(3, scaling);
+                                for (size_t i = 0; i < n; i++) {
+                                    if (i % folds != f) {
+                                        train.add(xs[i], ys[i]);
+                                    }
+                                }
+                                for (size_t degree = 1; degree <= 3; degree++) {
+                                    Polynomial c = polynomial_approximation(train, degree);
+                                    for (size_t i = f; i < n; i += folds) {
+                                        float e = evaluate(c, xs[i]) - ys[i];
+                                        S += e * e;
+                                    }
+                                }
+                            }
+                            return S;
+                        }, points},
+                        {"cv_fold_moments",         [&] {
+                            std::vector<CrossValidation> validations = cross_validate(
+                                    {Model::Lineal, Model::Quadratic, Model::Qube}, xs.data(), ys.data(), n, logs, 10);
+                            return validations[0].sse + validations[1].sse + validations[2].sse;
+                        }, points},
+                };
+
+                /* the shared columns refuse to fit a series with a y <= 0 (the noisy quadratic has some at 10^7) */
+                if (logs.hasLnX() && logs.hasLnY()) {
+                    cases.push_back({"log_fits_shared", [&] {
+                        LogColumns logs = compute_log_columns(xs, ys);
+                        std::pair<float, float> e = approx_exponential(xs.data(), logs);
+                        std::pair<float, float> p = approx_power(logs);
+                        std::pair<float, float> l = approx_log(ys.data(), logs);
+                        return sse_exponential(e.first, e.second, xs.data(), ys.data(), n)
+                               + sse_power_ln(p.first, p.second, logs.lnX.data(), ys.data(), n)
+                               + sse_log_ln(l.first, l.second, logs.lnX.data(), ys.data(), n);
+                    }, points});
+                }
+
+                for (const SuiteCase &c : cases) {
+                    results.push_back(timeCase(c, shape.name, n, sink));
+                }
+
+                if (n <= SUITE_TABLE_MAX_ROWS) {
+                    std::vector<std::string> headers = {"x", "y"};
+                    std::vector<std::vector<std::string>> rows(n);
+                    for (size_t i = 0; i < n; i++) {
+                        rows[i] = {std::to_string(xs[i]), std::to_string(ys[i])};
+                    }
+
+                    /* the table moves the bytes it writes, measured by a dry run */
+                    CountingBuffer counting;
+                    std::ostream counted(&counting);
+                    printTable(headers, rows, counted);
+
+                    SuiteCase table{"printTable", [&] {
+                        CountingBuffer discard;
+                        std::ostream out(&discard);
+                        printTable(headers, rows, out);
+                        return static_cast<float>(discard.count);
+                    }, static_cast<double>(counting.count)};
+
+                    results.push_back(timeCase(table, shape.name, n, sink));
+
+                    /* the same two columns streamed from the numbers, no cell is kept as a string */
+                    TableWriter writer({{"x"}, {"y"}});
+                    auto row = [&](size_t i, double *values) {
+                        values[0] = xs[i];
+                        values[1] = ys[i];
+                    };
+
+                    counting.count = 0;
+                    writer.write(n, row, counted);
+
+                    SuiteCase streamed{"TableWriter", [&] {
+                        CountingBuffer discard;
+                        std::ostream out(&discard);
+                        writer.write(n, row, out);
+                        return static_cast<float>(discard.count);
+                    }, static_cast<double>(counting.count)};
+
+                    results.push_back(timeCase(streamed, shape.name, n, sink));
+                }
+            }
+        }
+
+        std::FILE *json = std::fopen(jsonFile.c_str(), "w");
+        if (json == nullptr) {
+            throw std::runtime_error("Cannot write " + jsonFile);
+        }
+
+        std::fprintf(json, "{\n  \"isa\": \"%s\",\n  \"max_size\": %zu,\n  \"results\": [\n", kernels_isa(), maxSize);
+        for (size_t i = 0; i < results.size(); i++) {
+            const SuiteResult &r = results[i];
+            double nsPerPoint = r.nsPerCall / static_cast<double>(r.n);
+            double gbPerSecond = r.bytes / r.nsPerCall;
+
+            std::fprintf(json, "    {\"name\": \"%s\", \"shape\": \"%s\", \"n\": %zu, \"reps\": %zu, "
+                               "\"ns_per_call\": %.6g, \"ns_per_point\": %.6g, \"gb_per_s\": %.6g}%s\n",
+                         r.name.c_str(), r.shape, r.n, r.reps, r.nsPerCall, nsPerPoint, gbPerSecond,
+                         i + 1 < results.size() ? "," : "");
+
+            std::printf("suite %-24s %-12s n=%-10zu %10.3f ns/point %8.3f GB/s\n",
+                        r.name.c_str(), r.shape, r.n, nsPerPoint, gbPerSecond);
+        }
+        std::fprintf(json, "  ]\n}\n");
+        std::fclose(json);
+
+        std::printf("suite results written to %s (checksum %g)\n", jsonFile.c_str(), sink);
+    }
+
+    /*
+     * rolling lineal fit over the last W points, refreshed after every new point:
+     * WindowFit updates vs recomputing the moments of the whole window each time
+     */
+    void benchWindow() {
+        const size_t updates = 200000;
+        const size_t scratchUpdates = 2000;
+
+        for (size_t window : {100, 1000, 10000}) {
+            std::vector<float> xs, ys;
+            linearSeries(window + updates, xs, ys);
+
+            WindowFit rolling(window);
+            for (size_t i = 0; i < window; i++) {
+                rolling.add(xs[i], ys[i]);
+            }
+
+            float checksum = 0;
+            Clock::time_point start = Clock::now();
+            for (size_t i = window; i < window + updates; i++) {
+                rolling.add(xs[i], ys[i]);
+                checksum += rolling.lineal().first;
+            }
+            double rollingNs = secondsSince(start) * 1e9 / updates;
+
+            /* the last scratchUpdates windows refitted from scratch, compared against the rolling fit */
+            size_t first = window + updates - scratchUpdates;
+            WindowFit check(window);
+            for (size_t i = first - window; i < first; i++) {
+                check.add(xs[i], ys[i]);
+            }
+
+            float maxDrift = 0;
+            double scratchSeconds = 0;
+            for (size_t i = first; i < window + updates; i++) {
+                check.add(xs[i], ys[i]);
+
+                start = Clock::now();
+                Moments m(1);
+                for (size_t j = i + 1 - window; j <= i; j++) {
+                    m.add(xs[j], ys[j]);
+                }
+                std::pair<float, float> scratch = approx_lineal(m);
+                scratchSeconds += secondsSince(start);
+
+                maxDrift = std::max(maxDrift, std::abs(check.lineal().first - scratch.first));
+                checksum += scratch.first;
+            }
+            double scratchNs = scratchSeconds * 1e9 / scratchUpdates;
+
+            std::printf("window W=%zu: rolling %.1f ns/update, refit %.1f ns/update, speedup %.1fx, "
+                        "max slope drift %.3g (checksum %g)\n",
+                        window, rollingNs, scratchNs, scratchNs / rollingNs, maxDrift, checksum);
+        }
+    }
+
+    /* power sums in float running sums, the way Moments used to keep them: the baseline of the double ones */
+    struct FloatMoments {
+        size_t n = 0;
+        std::vector<float> sx;
+        std::vector<float> sxy;
+        float syy = 0;
+
+        explicit FloatMoments(size_t degree) : sx(2 * degree + 1, 0.0f), sxy(degree + 1, 0.0f) {}
+
+        void add(float x, float y) {
+            float p = 1.0f;
+            syy += y * y;
+            for (size_t k = 0; k < sx.size(); k++) {
+                sx[k] += p;
+                if (k < sxy.size()) {
+                    sxy[k] += p * y;
+                }
+                p *= x;
+            }
+            n++;
+        }
+
+        Moments value() const {
+            Moments m(sxy.size() - 1);
+            m.n = n;
+            m.sx.assign(sx.begin(), sx.end());
+            m.sxy.assign(sxy.begin(), sxy.end());
+            m.syy = syy;
+            return m;
+        }
+    };
+
+    /*
+     * drift of OnlineFit over a long stream of y = 2x + 1, x uniform in [0, 10): the line and the cube at
+     * checkpoints, against the same fits from plain float running sums (what OnlineFit used to keep).
+     * The exact answer is a = 2, b = 1 and the cube {1, 2, 0, 0}. The time of OnlineFit includes
+     * the logarithms it takes for the linearized fits
+     */
+    void benchOnline() {
+        const size_t checkpoints[] = {1000000, 3000000, 10000000, 30000000};
+        const size_t n = checkpoints[std::size(checkpoints) - 1];
+
+        auto describe = [](const Moments &m) {
+            char line[160];
+            try {
+                std::pair<float, float> lineal = approx_lineal(m);
+                int length = std::snprintf(line, sizeof(line), "a = %.7g, b = %.7g", lineal.first, lineal.second);
+                try {
+                    std::vector<float> cube = expanded(cube_approximation(m));
+                    std::snprintf(line + length, sizeof(line) - length, ", cube {%.3g, %.3g, %.3g, %.3g}",
+                                  cube[0], cube[1], cube[2], cube[3]);
+                } catch (const std::exception &) {
+                    std::snprintf(line + length, sizeof(line) - length, ", no cube");
+                }
+            } catch (const std::exception &) {
+                std::snprintf(line, sizeof(line), "no line");
+            }
+            return std::string(line);
+        };
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> uniform(0.0f, 10.0f);
+        std::vector<float> xs(n);
+        for (float &x : xs) {
+            x = uniform(gen);
+        }
+
+        /* the fits at the checkpoints are O(1) and kept out of the timing */
+        std::vector<std::string> onlineFits, naiveFits;
+        std::vector<double> drifts;
+
+        OnlineFit online(3);
+        double onlineSeconds = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0, next = 0; i < n; i++) {
+            online.add(xs[i], 2 * xs[i] + 1);
+
+            if (i + 1 == checkpoints[next]) {
+                onlineSeconds += secondsSince(start);
+                std::pair<float, float> line = online.lineal();
+                drifts.push_back(std::max(std::abs(line.first - 2.0), std::abs(line.second - 1.0)));
+                onlineFits.push_back(describe(online.polynomialMoments()));
+                next++;
+                start = Clock::now();
+            }
+        }
+
+        FloatMoments naive(3);
+        double naiveSeconds = 0;
+        start = Clock::now();
+        for (size_t i = 0, next = 0; i < n; i++) {
+            naive.add(xs[i], 2 * xs[i] + 1);
+
+            if (i + 1 == checkpoints[next]) {
+                naiveSeconds += secondsSince(start);
+                naiveFits.push_back(describe(naive.value()));
+                next++;
+                start = Clock::now();
+            }
+        }
+
+        for (size_t c = 0; c < std::size(checkpoints); c++) {
+            std::printf("online n=%zu: OnlineFit %s (drift %.2e); float sums %s\n",
+                        checkpoints[c], onlineFits[c].c_str(), drifts[c], naiveFits[c].c_str());
+        }
+        std::printf("online add: %.2f ns/point, float sums %.2f ns/point\n",
+                    onlineSeconds * 1e9 / n, naiveSeconds * 1e9 / n);
+    }
+
+    /*
+     * lineal and quadratic fits plus their S for many short series:
+     * one series at a time through the Moments API vs SERIES_LANES series side by side
+     */
+    void benchLanes() {
+        const size_t seriesCount = 100000;
+
+        for (size_t length : {10, 30, 100}) {
+            std::vector<FunctionPoints> series(seriesCount);
+            for (size_t s = 0; s < seriesCount; s++) {
+                linearSeries(length, series[s].first, series[s].second);
+            }
+
+            float checksum = 0;
+            Clock::time_point start = Clock::now();
+            for (const FunctionPoints &points : series) {
+                const std::vector<float> &xs = points.first;
+                const std::vector<float> &ys = points.second;
+
+                Moments m = compute_moments(xs, ys, 2);
+                std::pair<float, float> lineal = approx_lineal(m);
+                Polynomial quadratic = quadratic_approximation(m);
+
+                float lc[] = {lineal.second, lineal.first};
+                checksum += sse_polynomial(lc, 1, xs.data(), ys.data(), length);
+                checksum += deviation_polynomial(quadratic, xs, ys);
+            }
+            double singleNs = secondsSince(start) * 1e9 / seriesCount;
+
+            float lanesChecksum = 0;
+            SeriesLanes packed;
+            LaneFits fits;
+            start = Clock::now();
+            for (size_t s = 0; s < seriesCount; s += SERIES_LANES) {
+                const FunctionPoints *group[SERIES_LANES];
+                size_t count = std::min(SERIES_LANES, seriesCount - s);
+                for (size_t l = 0; l < count; l++) {
+                    group[l] = &series[s + l];
+                }
+
+                pack_series(group, count, packed);
+                fit_lanes(packed, fits);
+
+                for (size_t l = 0; l < count; l++) {
+                    lanesChecksum += fits.linealDeviation[l] + fits.quadraticDeviation[l];
+                }
+            }
+            double lanesNs = secondsSince(start) * 1e9 / seriesCount;
+
+            std::printf("lanes n=%zu: single %.1f ns/series, lanes %.1f ns/series, speedup %.1fx "
+                        "(checksums %g / %g)\n",
+                        length, singleNs, lanesNs, singleNs / lanesNs, checksum, lanesChecksum);
+        }
+    }
+
+    /*
+     * the linearized exp and power fits against the same fits refined by Levenberg–Marquardt:
+     * time per series and the total S of both over many series of the exponential shape
+     */
+    void benchRefine() {
+        const Shape &shape = SHAPES[2];
+
+        for (size_t length : {10, 100, 10000}) {
+            size_t seriesCount = std::max<size_t>(10, 1000000 / length);
+            std::vector<FunctionPoints> series(seriesCount);
+            for (size_t s = 0; s < seriesCount; s++) {
+                shapeSeries(shape, length, series[s].first, series[s].second);
+            }
+
+            for (bool refine : {false, true}) {
+                double expS = 0;
+                double powerS = 0;
+
+                Clock::time_point start = Clock::now();
+                for (const FunctionPoints &points : series) {
+                    const float *xs = points.first.data();
+                    const float *ys = points.second.data();
+
+                    std::pair<float, float> e = approx_exponential(xs, ys, length);
+                    std::pair<float, float> p = approx_power(xs, ys, length);
+                    if (refine) {
+                        e = refine_exponential(e.first, e.second, xs, ys, length);
+                        p = refine_power(p.first, p.second, xs, ys, length);
+                    }
+
+                    expS += sse_exponential(e.first, e.second, xs, ys, length);
+                    powerS += sse_power(p.first, p.second, xs, ys, length);
+                }
+                double ns = secondsSince(start) * 1e9 / seriesCount;
+
+                std::printf("refine n=%zu %s: %.1f ns/series, S exp %.6g, S power %.6g\n",
+                            length, refine ? "lm" : "linearized", ns, expS, powerS);
+            }
+        }
+    }
+
+    /* |got - exact| in units of the last place of the float nearest to exact, subnormal spacing below FLT_MIN */
+    double ulpError(float got, double exact) {
+        if (std::isnan(exact) || std::isnan(got)) {
+            return std::isnan(exact) && std::isnan(got) ? 0 : INFINITY;
+        }
+        if (std::abs(exact) > std::numeric_limits<float>::max()) {
+            return std::isinf(got) && (got > 0) == (exact > 0) ? 0 : INFINITY;
+        }
+
+        int exponent;
+        std::frexp(exact, &exponent);
+        double ulp = std::ldexp(1.0, std::max(exponent - 24, -149));
+        return std::abs(got - exact) / ulp;
+    }
+
+    /*
+     * one function of vecmath.h against libm: the largest error in ulp over every stride-th float
+     * from lo to hi (the exact value from the double function) and the time per value of both
+     */
+    template<typename Vector, typename Libm, typename Exact>
+    void benchMathFunction(const char *name, float lo, float hi, Vector vector, Libm libm, Exact exact) {
+        using namespace simd;
+
+        const uint32_t stride = 17;
+
+        /* floats of one sign are ordered like their bits, the negative ones run down from -0 */
+        std::vector<float> xs;
+        auto sweep = [&](uint32_t from, uint32_t to) {
+            for (uint64_t u = from; u <= to; u += stride) {
+                uint32_t bits = static_cast<uint32_t>(u);
+                float x;
+                std::memcpy(&x, &bits, sizeof(x));
+                xs.push_back(x);
+            }
+        };
+
+        uint32_t loBits, hiBits;
+        std::memcpy(&loBits, &lo, sizeof(loBits));
+        std::memcpy(&hiBits, &hi, sizeof(hiBits));
+        if (lo < 0) {
+            sweep(0x80000000u, loBits);
+            sweep(0, hiBits);
+        } else {
+            sweep(loBits, hiBits);
+        }
+        xs.resize(xs.size() - xs.size() % WIDTH);
+
+        std::vector<float> ys(xs.size());
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < xs.size(); i += WIDTH) {
+            store(ys.data() + i, vector(load(xs.data() + i)));
+        }
+        double vectorNs = secondsSince(start) * 1e9 / xs.size();
+
+        std::vector<float> reference(xs.size());
+        start = Clock::now();
+        for (size_t i = 0; i < xs.size(); i++) {
+            reference[i] = libm(xs[i]);
+        }
+        double libmNs = secondsSince(start) * 1e9 / xs.size();
+
+        double worst = 0;
+        double worstLibm = 0;
+        float worstX = 0;
+        for (size_t i = 0; i < xs.size(); i++) {
+            double value = exact(static_cast<double>(xs[i]));
+            double error = ulpError(ys[i], value);
+            if (error > worst) {
+                worst = error;
+                worstX = xs[i];
+            }
+            worstLibm = std::max(worstLibm, ulpError(reference[i], value));
+        }
+
+        std::printf("math %s: %zu values, vector %.2f ns, libm %.2f ns, speedup %.1fx, "
+                    "max error %.3f ulp at %g (libm %.3f ulp)\n",
+                    name, xs.size(), vectorNs, libmNs, libmNs / vectorNs, worst, worstX, worstLibm);
+    }
+
+    /* vexp, vlog and vpow of vecmath.h against std::exp, std::log and std::pow */
+    void benchMath() {
+        using namespace simd;
+
+        benchMathFunction("exp", -103.0f, 88.7f,
+                          [](Vec x) { return vexp(x); },
+                          [](float x) { return std::exp(x); },
+                          [](double x) { return std::exp(x); });
+
+        benchMathFunction("log", 0.0f, std::numeric_limits<float>::max(),
+                          [](Vec x) { return vlog(x); },
+                          [](float x) { return std::log(x); },
+                          [](double x) { return std::log(x); });
+
+        /* b * ln x within [-2, 2], see vecmath.h for the bound past it */
+        const float b = 0.98f;
+        benchMathFunction("pow", 0.13f, 7.6f,
+                          [b](Vec x) { return vpow(x, b); },
+                          [b](float x) { return std::pow(x, b); },
+                          [b](double x) { return std::pow(x, static_cast<double>(b)); });
+    }
+
+    /*
+     * a kernel of kernels.h and its reference: φ through std::pow, std::exp and std::log in double, the way
+     * deviation.cpp computed it before the kernels, and the size of the terms φ is made of
+     */
+    struct KernelCheck {
+        std::string name;
+        /* the kernel reads ln x_i in place of x_i */
+        bool lnX;
+        std::function<float(const float *us, const float *ys, size_t n)> sse;
+        /* empty for the kernels with no residuals_* counterpart */
+        std::function<void(const float *us, const float *ys, float *out, size_t n)> residuals;
+        std::function<double(double x)> phi;
+        std::function<double(double x)> magnitude;
+    };
+
+    /*
+     * every sse_* and residuals_* kernel against its reference on random series of many lengths: shorter than
+     * a vector (all scalar), whole vectors, whole vectors plus a tail, and across SUM_BLOCK boundaries.
+     * A residual may be off by 16 float ε of the terms of φ and y, S by what those errors add up to
+     * plus the rounding of the sums. Returns false if any kernel is off by more.
+     */
+    bool verifyKernels() {
+        using namespace simd;
+
+        const double eps = std::numeric_limits<float>::epsilon();
+        const double tolerance = 16 * eps;
+        const size_t sizes[] = {1, 2, WIDTH - 1, WIDTH, WIDTH + 1, 2 * WIDTH + 3, SUM_BLOCK - 1, SUM_BLOCK,
+                                SUM_BLOCK + WIDTH + 5, 1000, 100003};
+
+        std::vector<KernelCheck> checks;
+
+        const float c[] = {1.5f, -2.0f, 0.75f, -0.125f, 0.03125f, -0.0078125f};
+        for (size_t degree : {1, 2, 3, 5}) {
+            auto phi = [c, degree](double x) {
+                double p = 0;
+                for (size_t k = 0; k <= degree; k++) {
+                    p += c[k] * std::pow(x, static_cast<double>(k));
+                }
+                return p;
+            };
+            auto magnitude = [c, degree](double x) {
+                double m = 0;
+                for (size_t k = 0; k <= degree; k++) {
+                    m += std::abs(c[k] * std::pow(x, static_cast<double>(k)));
+                }
+                return m;
+            };
+
+            checks.push_back({"polynomial degree " + std::to_string(degree), false,
+                              [c, degree](const float *xs, const float *ys, size_t n) {
+                                  return sse_polynomial(c, degree, xs, ys, n);
+                              },
+                              [c, degree](const float *xs, const float *ys, float *out, size_t n) {
+                                  residuals_polynomial(c, degree, xs, ys, out, n);
+                              }, phi, magnitude});
+        }
+
+        const float a = 1.75f, b = 0.625f;
+
+        checks.push_back({"exponential", false,
+                          [=](const float *xs, const float *ys, size_t n) { return sse_exponential(a, b, xs, ys, n); },
+                          [=](const float *xs, const float *ys, float *out, size_t n) {
+                              residuals_exponential(a, b, xs, ys, out, n);
+                          },
+                          [=](double x) { return a * std::exp(b * x); },
+                          [=](double x) { return a * std::exp(b * x) * (1 + std::abs(b * x)); }});
+
+        checks.push_back({"power", false,
+                          [=](const float *xs, const float *ys, size_t n) { return sse_power(a, b, xs, ys, n); },
+                          [=](const float *xs, const float *ys, float *out, size_t n) {
+                              residuals_power(a, b, xs, ys, out, n);
+                          },
+                          [=](double x) { return a * std::pow(x, static_cast<double>(b)); },
+                          [=](double x) {
+                              return a * std::pow(x, static_cast<double>(b)) * (1 + 2 * std::abs(b * std::log(x)));
+                          }});
+
+        checks.push_back({"log", false,
+                          [=](const float *xs, const float *ys, size_t n) { return sse_log(a, b, xs, ys, n); },
+                          [=](const float *xs, const float *ys, float *out, size_t n) {
+                              residuals_log(a, b, xs, ys, out, n);
+                          },
+                          [=](double x) { return a * std::log(x) + b; },
+                          [=](double x) { return std::abs(a * std::log(x)) + std::abs(b) + a; }});
+
+        /* ln x rounded to float is off by half an ulp of ln x, which the magnitudes carry as well */
+        checks.push_back({"power from ln x", true,
+                          [=](const float *lnXs, const float *ys, size_t n) { return sse_power_ln(a, b, lnXs, ys, n); },
+                          nullptr,
+                          [=](double x) { return a * std::pow(x, static_cast<double>(b)); },
+                          [=](double x) {
+                              return a * std::pow(x, static_cast<double>(b)) * (1 + 2 * std::abs(b * std::log(x)));
+                          }});
+
+        checks.push_back({"log from ln x", true,
+                          [=](const float *lnXs, const float *ys, size_t n) { return sse_log_ln(a, b, lnXs, ys, n); },
+                          nullptr,
+                          [=](double x) { return a * std::log(x) + b; },
+                          [=](double x) { return std::abs(a * std::log(x)) + std::abs(b) + a; }});
+
+        bool passed = true;
+
+        for (const KernelCheck &check : checks) {
+            /* the worst error of all the sizes as a share of what is allowed, above 1 is a failure */
+            double worstSse = 0;
+            double worstResidual = 0;
+
+            for (size_t n : sizes) {
+                std::mt19937 gen(static_cast<unsigned>(n));
+                std::uniform_real_distribution<float> uniform(0.25f, 4.0f);
+                std::normal_distribution<float> noise(0.0f, 0.1f);
+
+                std::vector<float> xs(n), ys(n), lnXs(n), out(n);
+                for (size_t i = 0; i < n; i++) {
+                    xs[i] = uniform(gen);
+                    ys[i] = static_cast<float>(check.phi(xs[i]) * (1 + noise(gen)));
+                    lnXs[i] = std::log(xs[i]);
+                }
+
+                const float *us = check.lnX ? lnXs.data() : xs.data();
+
+                double exactS = 0;
+                double allowedS = 0;
+                for (size_t i = 0; i < n; i++) {
+                    double e = check.phi(xs[i]) - ys[i];
+                    double allowed = tolerance * check.magnitude(xs[i]) + eps * std::abs(ys[i]);
+                    exactS += e * e;
+                    allowedS += 2 * std::abs(e) * allowed + allowed * allowed;
+                }
+                allowedS += SUM_BLOCK * eps * exactS;
+
+                worstSse = std::max(worstSse, std::abs(check.sse(us, ys.data(), n) - exactS) / allowedS);
+
+                if (check.residuals) {
+                    check.residuals(us, ys.data(), out.data(), n);
+                    for (size_t i = 0; i < n; i++) {
+                        double e = check.phi(xs[i]) - ys[i];
+                        double allowed = tolerance * check.magnitude(xs[i]) + eps * std::abs(ys[i]);
+                        worstResidual = std::max(worstResidual, std::abs(out[i] - e) / allowed);
+                    }
+                }
+            }
+
+            bool ok = worstSse <= 1 && worstResidual <= 1;
+            passed = passed && ok;
+
+            std::printf("verify %-20s S at most %.3f of the tolerance, residuals %.3f: %s\n",
+                        check.name.c_str(), worstSse, worstResidual, ok ? "ok" : "MISMATCH");
+        }
+
+        std::printf("verify %s kernels on %zu sizes: %s\n", kernels_isa(), std::size(sizes),
+                    passed ? "all match the reference" : "FAILED");
+        return passed;
+    }
+
+    /*
+     * polynomial_approximation of degrees 4 to 6 on x away from zero, where the normal system in x is hopeless:
+     * φ(x) = Σ c_k u^k, u = (x - middle) / 5, with the c_k alternating in sign and growing with k.
+     *
+     * Without noise the coefficients of t have to come back: φ taken into the t of the fit,
+     * u = α + β t, has the coefficients q_j = Σ[k = j, m] c_k * C(k, j) * α^(k - j) * β^j, and every b_j
+     * may be off by 10^-3 of the largest q. With noise σ the residual sd may not exceed 1.25 σ.
+     * Returns false if any fit fails or is off by more.
+     */
+    bool verifyPolyfit() {
+        const float sigma = 0.1f;
+        bool passed = true;
+
+        for (float low : {0.0f, 1.0f, 100.0f}) {
+            for (size_t n : {50, 1000}) {
+                for (size_t degree = 4; degree <= 6; degree++) {
+                    std::mt19937 gen(static_cast<unsigned>(n + degree));
+                    std::uniform_real_distribution<float> uniform(low, low + 10);
+                    std::normal_distribution<float> noise(0.0f, sigma);
+
+                    const double middle = low + 5.0;
+                    auto phi = [degree, middle](double x) {
+                        double u = (x - middle) / 5;
+                        double p = 0;
+                        for (size_t k = degree + 1; k-- > 0;) {
+                            p = p * u + (k % 2 ? 1.0 : -1.0) * static_cast<double>(k + 1);
+                        }
+                        return p;
+                    };
+
+                    std::vector<float> xs(n), exact(n), noisy(n);
+                    for (size_t i = 0; i < n; i++) {
+                        xs[i] = uniform(gen);
+                        exact[i] = static_cast<float>(phi(xs[i]));
+                        noisy[i] = exact[i] + noise(gen);
+                    }
+
+                    double coefficientError = 0;
+                    double sd = 0;
+                    bool ok = true;
+
+                    try {
+                        Polynomial fit = polynomial_approximation(xs, exact, degree);
+
+                        const double alpha = (fit.scaling.center - middle) / 5;
+                        const double beta = fit.scaling.scale / 5;
+
+                        double largest = 0;
+                        std::vector<double> q(degree + 1);
+                        for (size_t j = 0; j <= degree; j++) {
+                            double binomial = 1; /* C(k, j) */
+                            for (size_t k = j; k <= degree; k++) {
+                                double c = (k % 2 ? 1.0 : -1.0) * static_cast<double>(k + 1);
+                                q[j] += c * binomial * std::pow(alpha, static_cast<double>(k - j))
+                                        * std::pow(beta, static_cast<double>(j));
+                                binomial = binomial * static_cast<double>(k + 1) / static_cast<double>(k + 1 - j);
+                            }
+                            largest = std::max(largest, std::abs(q[j]));
+                        }
+                        for (size_t j = 0; j <= degree; j++) {
+                            coefficientError = std::max(coefficientError,
+                                                        std::abs(fit.coefficients[j] - q[j]) / largest);
+                        }
+
+                        sd = std::sqrt(deviation_polynomial(polynomial_approximation(xs, noisy, degree), xs, noisy)
+                                       / static_cast<double>(n));
+
+                        ok = coefficientError <= 1e-3 && sd <= 1.25 * sigma;
+                    } catch (const std::exception &e) {
+                        ok = false;
+                    }
+                    passed = passed && ok;
+
+                    std::printf("verify degree %zu on x in [%g, %g], n = %-4zu coefficients off by %.1e, sd %.4f: %s\n",
+                                degree, low, low + 10, n, coefficientError, sd, ok ? "ok" : "MISMATCH");
+                }
+            }
+        }
+
+        std::printf("verify polynomial fits away from zero: %s\n", passed ? "all recovered" : "FAILED");
+        return passed;
+    }
+
+    /*
+     * accuracy and speed of the moment sums over a long series:
+     * one plain float running sum per power (the old compute_moments) against the double sums of
+     * compute_moments, both checked against long double sums
+     */
+    void benchSummation() {
+        const size_t n = 10000000;
+        const size_t degree = 3;
+
+        std::vector<float> xs(n), ys(n);
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> x(0.0f, 10.0f);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+        for (size_t i = 0; i < n; i++) {
+            xs[i] = x(gen);
+            ys[i] = 0.01f * xs[i] * xs[i] * xs[i] - 0.2f * xs[i] * xs[i] + xs[i] + 3 + noise(gen);
+        }
+
+        /* the reference in long double, not timed */
+        std::vector<long double> exact(2 * degree + 1), exactXY(degree + 1);
+        long double exactYY = 0;
+        for (size_t i = 0; i < n; i++) {
+            long double p = 1;
+            exactYY += static_cast<long double>(ys[i]) * ys[i];
+            for (size_t k = 0; k <= 2 * degree; k++) {
+                exact[k] += p;
+                if (k <= degree) {
+                    exactXY[k] += p * ys[i];
+                }
+                p *= xs[i];
+            }
+        }
+
+        Clock::time_point start = Clock::now();
+        FloatMoments naive(degree);
+        for (size_t i = 0; i < n; i++) {
+            naive.add(xs[i], ys[i]);
+        }
+        double naiveNs = secondsSince(start) * 1e9 / n;
+
+        start = Clock::now();
+        /* in x like the float sums and the reference, compute_moments would center them */
+        Moments moments = compute_moments(xs.data(), ys.data(), n, degree, XScaling());
+        double momentsNs = secondsSince(start) * 1e9 / n;
+
+        auto worstError = [&](const Moments &m) {
+            long double worst = 0;
+            for (size_t k = 0; k <= 2 * degree; k++) {
+                worst = std::max(worst, std::abs(m.sx[k] - exact[k]) / std::abs(exact[k]));
+            }
+            for (size_t k = 0; k <= degree; k++) {
+                worst = std::max(worst, std::abs(m.sxy[k] - exactXY[k]) / std::abs(exactXY[k]));
+            }
+            return static_cast<double>(std::max(worst, std::abs(m.syy - exactYY) / exactYY));
+        };
+
+        std::printf("summation n=%zu: float sums %.2f ns/point (max rel. error %.2e), "
+                    "compute_moments (double) %.2f ns/point (max rel. error %.2e)\n",
+                    n, naiveNs, worstError(naive.value()), momentsNs, worstError(moments));
+
+        std::vector<float> naiveCube = expanded(cube_approximation(naive.value()));
+        std::vector<float> cube = expanded(cube_approximation(moments));
+        std::printf("summation cube fit, true {3, 1, -0.2, 0.01}: float sums {%g, %g, %g, %g}, "
+                    "compute_moments {%g, %g, %g, %g}\n",
+                    naiveCube[0], naiveCube[1], naiveCube[2], naiveCube[3],
+                    cube[0], cube[1], cube[2], cube[3]);
+
+        /* S of the true curve, the kernel against a double reference */
+        float c[] = {3, 1, -0.2f, 0.01f};
+        double exactS = 0;
+        for (size_t i = 0; i < n; i++) {
+            double e = ((0.01 * xs[i] - 0.2) * xs[i] + 1) * xs[i] + 3 - ys[i];
+            exactS += e * e;
+        }
+
+        start = Clock::now();
+        float S = sse_polynomial(c, 3, xs.data(), ys.data(), n);
+        double kernelNs = secondsSince(start) * 1e9 / n;
+
+        std::printf("summation sse_polynomial: %.2f ns/point, rel. error %.2e\n",
+                    kernelNs, std::abs(S - exactS) / exactS);
+
+        /*
+         * S of the fitted cube from the moments alone (see diagnostics.h) against a double pass over the same
+         * t, for the first 10^5 points and for all of them; nan where the bound is beyond float ε of S
+         */
+        for (size_t count : {size_t(100000), n}) {
+            Moments m = compute_moments(xs.data(), ys.data(), count, degree);
+            Polynomial fitted = cube_approximation(m);
+
+            double fittedS = 0;
+            for (size_t i = 0; i < count; i++) {
+                double t = fitted.scaling.t(xs[i]);
+                const std::vector<float> &b = fitted.coefficients;
+                double e = ((b[3] * t + b[2]) * t + b[1]) * t + b[0] - ys[i];
+                fittedS += e * e;
+            }
+
+            float momentS = polynomial_sse({Model::Qube, fitted.coefficients, fitted.scaling}, m);
+            std::printf("summation polynomial_sse n=%zu: O(1), rel. error %.2e\n",
+                        count, std::abs(momentS - fittedS) / fittedS);
+        }
+    }
+
+    /* the loop readFunctionPointsFromFile used before the parallel parser, kept as the baseline */
+    FunctionPoints readWithStringStream(const std::string &fileName) {
+        std::ifstream file(fileName);
+
+        std::string line;
+        std::getline(file, line);
+
+        std::istringstream xs_stream(line);
+        std::vector<float> xs;
+
+        float x;
+        while (xs_stream >> x) {
+            xs.push_back(x);
+        }
+
+        std::getline(file, line);
+        std::istringstream ysStream(line);
+        std::vector<float> ys;
+
+        float y;
+        while (ysStream >> y) {
+            ys.push_back(y);
+        }
+
+        return {xs, ys};
+    }
+
+    /* text format parsing throughput, istringstream loop vs the from_chars parser on 1 and all threads */
+    void benchParser() {
+        const size_t n = 5000000;
+
+        std::vector<float> xs, ys;
+        linearSeries(n, xs, ys);
+
+        std::string fileName = (std::filesystem::temp_directory_path() / "function_approximation_bench.txt").string();
+        {
+            std::ofstream file(fileName);
+            for (size_t i = 0; i < n; i++) {
+                file << xs[i] << (i + 1 < n ? " " : "\n");
+            }
+            for (size_t i = 0; i < n; i++) {
+                file << ys[i] << (i + 1 < n ? " " : "\n");
+            }
+        }
+
+        double megabytes = static_cast<double>(std::filesystem::file_size(fileName)) / (1 << 20);
+
+        auto report = [megabytes](const char *name, double seconds, const FunctionPoints &points) {
+            std::printf("parser %-14s %8.1f MB/s (%.3f s, %zu + %zu points)\n",
+                        name, megabytes / seconds, seconds, points.first.size(), points.second.size());
+        };
+
+        Clock::time_point start = Clock::now();
+        FunctionPoints baseline = readWithStringStream(fileName);
+        report("istringstream", secondsSince(start), baseline);
+
+        start = Clock::now();
+        FunctionPoints single = readFunctionPointsFromFile(fileName, 1);
+        report("from_chars x1", secondsSince(start), single);
+
+        start = Clock::now();
+        FunctionPoints parallel = readFunctionPointsFromFile(fileName);
+        report("from_chars xN", secondsSince(start), parallel);
+
+        if (parallel != baseline) {
+            std::printf("parser MISMATCH against the istringstream result\n");
+        }
+
+        std::filesystem::remove(fileName);
+    }
+}
+
+/*
+ * bench [suite|window|online|lanes|refine|math|summation|parser] [--max-size N] [--json FILE]
+ * runs every benchmark when none is named; the suite sweeps up to 10^8 points unless --max-size is lower.
+ * bench verify only checks the kernels against their reference, bench polyfit the polynomial fits
+ * away from zero; both exit with 1 on a mismatch
+ */
+int main(int argc, char **argv) {
+    std::string only;
+    size_t maxSize = 100000000;
+    std::string jsonFile = "bench.json";
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            maxSize = std::stoull(argv[++i]);
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else {
+            only = argv[i];
+        }
+    }
+
+    if (only == "verify") {
+        return verifyKernels() ? 0 : 1;
+    }
+
+    if (only == "polyfit") {
+        return verifyPolyfit() ? 0 : 1;
+    }
+
+    if (only.empty() || only == "suite") {
+        benchSuite(maxSize, jsonFile);
+    }
+
+    if (only.empty() || only == "window") {
+        benchWindow();
+    }
+
+    if (only.empty() || only == "online") {
+        benchOnline();
+    }
+
+    if (only.empty() || only == "lanes") {
+        benchLanes();
+    }
+
+    if (only.empty() || only == "refine") {
+        benchRefine();
+    }
+
+    if (only.empty() || only == "math") {
+        benchMath();
+    }
+
+    if (only.empty() || only == "summation") {
+        benchSummation();
+    }
+
+    if (only.empty() || only == "parser") {
+        benchParser();
+    }
+
+    return 0;
+}
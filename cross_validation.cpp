@@ -0,0 +1,260 @@
+#include "cross_validation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "deviation.h"
+#include "moments.h"
+#include "polyfit.h"
+#include "profile.h"
+#include "summation.h"
+
+namespace {
+    /* the least squares problem of a model: v = P(u), φ = P(u) or e^P(u); us is nullptr without the logarithms */
+    struct Problem {
+        const float *us = nullptr;
+        const float *vs = nullptr;
+        bool exponential = false;
+    };
+
+    Problem problemOf(Model model, const float *xs, const float *ys, size_t n, const LogColumns &logs) {
+        bool own = logs.n == n;
+        const float *lnXs = own && logs.hasLnX() ? logs.lnX.data() : nullptr;
+        const float *lnYs = own && logs.hasLnY() ? logs.lnY.data() : nullptr;
+
+        switch (model) {
+            case Model::Exp: return {lnYs ? xs : nullptr, lnYs, true};
+            case Model::Power: return {lnYs ? lnXs : nullptr, lnYs, true};
+            case Model::Log: return {lnXs, ys, false};
+            default: return {xs, ys, false};
+        }
+    }
+
+    size_t degreeOf(Model model) {
+        switch (model) {
+            case Model::Quadratic: return 2;
+            case Model::Qube: return 3;
+            default: return 1;
+        }
+    }
+
+    /* the sums of Moments one after another, so they are added up and subtracted all alike */
+    size_t termCount(const Moments &m) {
+        return m.sx.size() + m.sxy.size() + 1;
+    }
+
+    double &term(Moments &m, size_t t) {
+        if (t < m.sx.size()) {
+            return m.sx[t];
+        }
+        t -= m.sx.size();
+        return t < m.sxy.size() ? m.sxy[t] : m.syy;
+    }
+
+    double term(const Moments &m, size_t t) {
+        return term(const_cast<Moments &>(m), t);
+    }
+
+    /* the moments of every fold in one pass, point i is in fold i mod k; all of them centered on the whole of u */
+    std::vector<Moments> foldMoments(const Problem &p, size_t n, size_t degree, size_t k) {
+        std::vector<Moments> folds(k, Moments(degree, centered_scaling(p.us, n)));
+
+        for (size_t i = 0, f = 0; i < n; i++) {
+            folds[f].add(p.us[i], p.vs[i]);
+            if (++f == k) {
+                f = 0;
+            }
+        }
+
+        return folds;
+    }
+
+    Moments totalOf(const std::vector<Moments> &folds) {
+        Moments total = folds.front();
+        size_t terms = termCount(total);
+
+        for (size_t f = 1; f < folds.size(); f++) {
+            for (size_t t = 0; t < terms; t++) {
+                term(total, t) += term(folds[f], t);
+            }
+            total.n += folds[f].n;
+        }
+
+        return total;
+    }
+
+    /* the training set of a fold: every sum of the total with the fold taken out */
+    void subtract(Moments &train, const Moments &fold) {
+        size_t terms = termCount(train);
+        for (size_t t = 0; t < terms; t++) {
+            term(train, t) -= term(fold, t);
+        }
+        train.n -= fold.n;
+    }
+
+    float predict(const Polynomial &c, float u, bool exponential) {
+        float p = evaluate(c, u);
+        return exponential ? std::exp(p) : p;
+    }
+
+    /* S of the held out points, each one predicted by the fit of its own fold (point i by c[i mod k]) */
+    float heldOutSse(const Problem &p, const float *ys, size_t n, const std::vector<Polynomial> &c) {
+        size_t k = c.size();
+        CompensatedSum S;
+
+        size_t f = 0;
+        for (size_t begin = 0; begin < n; begin += SUM_BLOCK) {
+            size_t end = std::min(n, begin + SUM_BLOCK);
+
+            float block = 0;
+            for (size_t i = begin; i < end; i++) {
+                float e = predict(c[f], p.us[i], p.exponential) - ys[i];
+                block = std::fma(e, e, block);
+                if (++f == k) {
+                    f = 0;
+                }
+            }
+            S.add(block);
+        }
+
+        return S.value();
+    }
+
+    /* k-fold: the fold moments once, then k fits of every model and one pass over the held out points */
+    void validateFolds(const Problem &p, const float *ys, size_t n, size_t k, size_t degree,
+                       const std::vector<CrossValidation *> &targets) {
+        std::vector<Moments> folds = foldMoments(p, n, degree, k);
+        Moments total = totalOf(folds);
+
+        for (CrossValidation *target : targets) {
+            std::vector<Polynomial> coefficients(k);
+
+            try {
+                for (size_t f = 0; f < k; f++) {
+                    Moments train = total;
+                    subtract(train, folds[f]);
+                    coefficients[f] = polynomial_approximation(train, degreeOf(target->model));
+                }
+            } catch (const std::exception &) {
+                target->sse = std::numeric_limits<float>::quiet_NaN();
+                continue;
+            }
+
+            target->sse = heldOutSse(p, ys, n, coefficients);
+        }
+    }
+
+    /* leave-one-out: a fold is a single point, taken out of the total with Moments::remove */
+    void validateEach(const Problem &p, const float *ys, size_t n, size_t degree,
+                      const std::vector<CrossValidation *> &targets) {
+        Moments total = compute_moments(p.us, p.vs, n, degree);
+        Moments train = total;
+
+        std::vector<CompensatedSum> S(targets.size());
+        std::vector<float> block(targets.size(), 0.0f);
+
+        for (size_t i = 0; i < n; i++) {
+            train = total;
+            train.remove(p.us[i], p.vs[i]);
+
+            for (size_t m = 0; m < targets.size(); m++) {
+                float e;
+                try {
+                    Polynomial c = polynomial_approximation(train, degreeOf(targets[m]->model));
+                    e = predict(c, p.us[i], p.exponential) - ys[i];
+                } catch (const std::exception &) {
+                    e = std::numeric_limits<float>::quiet_NaN();
+                }
+                block[m] = std::fma(e, e, block[m]);
+            }
+
+            if ((i + 1) % SUM_BLOCK == 0 || i + 1 == n) {
+                for (size_t m = 0; m < targets.size(); m++) {
+                    S[m].add(block[m]);
+                    block[m] = 0;
+                }
+            }
+        }
+
+        for (size_t m = 0; m < targets.size(); m++) {
+            targets[m]->sse = S[m].value();
+        }
+    }
+
+    void validate(const Problem &p, const float *ys, size_t n, size_t k, const std::vector<CrossValidation *> &targets) {
+        if (targets.empty()) {
+            return;
+        }
+
+        if (p.us == nullptr) {
+            for (CrossValidation *target : targets) {
+                target->sse = std::numeric_limits<float>::quiet_NaN();
+            }
+            return;
+        }
+
+        size_t degree = 0;
+        for (const CrossValidation *target : targets) {
+            degree = std::max(degree, degreeOf(target->model));
+        }
+
+        if (k == n) {
+            validateEach(p, ys, n, degree, targets);
+        } else {
+            validateFolds(p, ys, n, k, degree, targets);
+        }
+    }
+}
+
+CrossValidation cross_validate(Model model, const float *xs, const float *ys, size_t n, const LogColumns &logs,
+                               size_t folds) {
+    return cross_validate(std::vector<Model>{model}, xs, ys, n, logs, folds).front();
+}
+
+std::vector<CrossValidation> cross_validate(const std::vector<Model> &models, const float *xs, const float *ys,
+                                            size_t n, const LogColumns &logs, size_t folds) {
+    PROFILE_SCOPE("cross_validate");
+    PROFILE_COUNT("points", n);
+
+    size_t k = folds == 0 ? n : folds;
+    if (k < 2 || k > n) {
+        throw std::runtime_error("Cross-validation needs from 2 to n folds!");
+    }
+
+    std::vector<CrossValidation> result(models.size());
+    std::vector<CrossValidation *> polynomials;
+
+    for (size_t i = 0; i < models.size(); i++) {
+        result[i].model = models[i];
+        result[i].folds = k;
+
+        if (degreeOf(models[i]) > 1 || models[i] == Model::Lineal) {
+            polynomials.push_back(&result[i]);
+        } else {
+            validate(problemOf(models[i], xs, ys, n, logs), ys, n, k, {&result[i]});
+        }
+    }
+
+    validate(problemOf(Model::Lineal, xs, ys, n, logs), ys, n, k, polynomials);
+
+    for (CrossValidation &validation : result) {
+        validation.standardDeviation = standard_deviation(validation.sse, n);
+    }
+
+    return result;
+}
+
+const CrossValidation *best_validation(const std::vector<CrossValidation> &validations) {
+    const CrossValidation *best = nullptr;
+
+    for (const CrossValidation &validation : validations) {
+        if (!std::isnan(validation.standardDeviation)
+            && (best == nullptr || validation.standardDeviation < best->standardDeviation)) {
+            best = &validation;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,47 @@
+#ifndef FUNCTION_APPROXIMATION_CROSS_VALIDATION_H
+#define FUNCTION_APPROXIMATION_CROSS_VALIDATION_H
+
+#include <cstddef>
+#include <vector>
+
+#include "log_columns.h"
+#include "model.h"
+
+/*
+ * k-fold cross-validation: point i goes to fold i mod k, every fold is predicted by the model fitted
+ * on the other k - 1 folds, and the errors of all the predictions make up S. Unlike δ of the fit itself,
+ * which only goes down as coefficients are added, this δ grows again once a model starts to fit the noise.
+ * folds = 0 (or n) is leave-one-out. Folds are taken in turn rather than in runs, so data sorted by x
+ * does not turn every fold into an extrapolation.
+ *
+ * Every model is a least squares polynomial v = P(u) (see moments.h), so a fold is fitted without refitting:
+ *
+ * lineal, quadratic, qube  u = x     v = y     φ = P(x)
+ * exp                      u = x     v = ln y  φ = e^P(x)
+ * power                    u = ln x  v = ln y  φ = e^P(ln x)
+ * log                      u = ln x  v = y     φ = P(ln x)
+ *
+ * One pass takes the moments of every fold, the training moments of a fold are the total minus the fold,
+ * so the k fits cost O(k * d^3) on top of O(N) for the moments and the held out errors. The polynomial models
+ * share the moments of degree 3. Power and exp are validated as their linearized fits (without refine.h).
+ *
+ * A model that can not be fitted on some training set (too few points, no logarithm) gets nan.
+ */
+struct CrossValidation {
+    Model model = Model::Lineal;
+    size_t folds = 0;
+    float sse = 0;                  /* S = Σ(φ_f(x_i) - y_i)^2, φ_f fitted without the fold f of point i */
+    float standardDeviation = 0;    /* δ = sqrt(S / n) */
+};
+
+CrossValidation cross_validate(Model model, const float *xs, const float *ys, size_t n, const LogColumns &logs,
+                               size_t folds);
+
+/* every model in the order of models, the polynomial ones from one set of fold moments */
+std::vector<CrossValidation> cross_validate(const std::vector<Model> &models, const float *xs, const float *ys,
+                                            size_t n, const LogColumns &logs, size_t folds);
+
+/* the validation with the smallest δ, nan ones are skipped; nullptr if there is none */
+const CrossValidation *best_validation(const std::vector<CrossValidation> &validations);
+
+#endif //FUNCTION_APPROXIMATION_CROSS_VALIDATION_H
@@ -0,0 +1,120 @@
+#include "decimate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+FunctionPoints sortedByX(const std::vector<float> &xs, const std::vector<float> &ys) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+
+    if (std::is_sorted(xs.begin(), xs.end())) {
+        return {xs, ys};
+    }
+
+    std::vector<size_t> order(xs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&xs](size_t l, size_t r) {
+        return xs[l] < xs[r];
+    });
+
+    FunctionPoints sorted;
+    sorted.first.reserve(xs.size());
+    sorted.second.reserve(ys.size());
+    for (size_t i : order) {
+        sorted.first.push_back(xs[i]);
+        sorted.second.push_back(ys[i]);
+    }
+
+    return sorted;
+}
+
+FunctionPoints lttb(const std::vector<float> &xs, const std::vector<float> &ys, size_t target) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+    if (target < 3) {
+        throw std::runtime_error("Downsampling needs a target of at least 3 points!");
+    }
+
+    size_t n = xs.size();
+    if (n <= target) {
+        return {xs, ys};
+    }
+
+    FunctionPoints kept;
+    kept.first.reserve(target);
+    kept.second.reserve(target);
+
+    kept.first.push_back(xs[0]);
+    kept.second.push_back(ys[0]);
+
+    /* bucket b covers the points [1 + b * size, 1 + (b + 1) * size) of the n - 2 inner ones */
+    double size = static_cast<double>(n - 2) / static_cast<double>(target - 2);
+    auto bucketBegin = [size](size_t b) {
+        return 1 + static_cast<size_t>(static_cast<double>(b) * size);
+    };
+
+    size_t previous = 0;
+
+    for (size_t b = 0; b < target - 2; b++) {
+        size_t begin = bucketBegin(b);
+        size_t end = bucketBegin(b + 1);
+
+        /* the next bucket is represented by its average, the last point stands for the one after the end */
+        size_t nextBegin = end;
+        size_t nextEnd = b + 3 < target ? bucketBegin(b + 2) : n;
+
+        double averageX = 0;
+        double averageY = 0;
+        for (size_t i = nextBegin; i < nextEnd; i++) {
+            averageX += xs[i];
+            averageY += ys[i];
+        }
+        averageX /= static_cast<double>(nextEnd - nextBegin);
+        averageY /= static_cast<double>(nextEnd - nextBegin);
+
+        double px = xs[previous];
+        double py = ys[previous];
+
+        size_t chosen = begin;
+        double largest = -1;
+
+        for (size_t i = begin; i < end; i++) {
+            /* twice the triangle area, the factor does not change which point wins */
+            double area = std::abs((px - averageX) * (ys[i] - py) - (px - xs[i]) * (averageY - py));
+            if (area > largest) {
+                largest = area;
+                chosen = i;
+            }
+        }
+
+        kept.first.push_back(xs[chosen]);
+        kept.second.push_back(ys[chosen]);
+        previous = chosen;
+    }
+
+    kept.first.push_back(xs[n - 1]);
+    kept.second.push_back(ys[n - 1]);
+
+    return kept;
+}
+
+std::vector<float> uniformGrid(float lo, float hi, size_t points) {
+    std::vector<float> grid(points);
+    if (points < 2) {
+        std::fill(grid.begin(), grid.end(), lo);
+        return grid;
+    }
+
+    double step = (static_cast<double>(hi) - lo) / static_cast<double>(points - 1);
+    for (size_t i = 0; i + 1 < points; i++) {
+        grid[i] = static_cast<float>(lo + step * static_cast<double>(i));
+    }
+    /* lo + step * (points - 1) can miss hi by a rounding, the end of the range is kept exact */
+    grid[points - 1] = hi;
+
+    return grid;
+}
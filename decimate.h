@@ -0,0 +1,23 @@
+#ifndef FUNCTION_APPROXIMATION_DECIMATE_H
+#define FUNCTION_APPROXIMATION_DECIMATE_H
+
+#include <vector>
+
+#include "points_file.h"
+
+/* the points ordered by x (ties keep their order), a curve through unsorted points zigzags back and forth */
+FunctionPoints sortedByX(const std::vector<float> &xs, const std::vector<float> &ys);
+
+/*
+ * largest-triangle-three-buckets downsampling to at most target points (target >= 3):
+ * the first and the last point are kept, the points between them are split into target - 2 buckets
+ * and every bucket keeps the point forming the largest triangle with the point kept before it and
+ * the average of the next bucket, so peaks and dips survive where plain striding would drop them.
+ * xs must be sorted; a series of at most target points is returned as it is.
+ */
+FunctionPoints lttb(const std::vector<float> &xs, const std::vector<float> &ys, size_t target);
+
+/* points evenly spaced from lo to hi, both included */
+std::vector<float> uniformGrid(float lo, float hi, size_t points);
+
+#endif //FUNCTION_APPROXIMATION_DECIMATE_H
@@ -1,14 +1,17 @@
 #include "deviation.h"
 
+#include "summation.h"
 
-
-float average(std::vector<float> &v) {
+float average(const std::vector<float> &v) {
     if (v.empty()) {
         return 0;
     }
 
     auto const size = static_cast<float>(v.size());
-    return std::accumulate(v.begin(), v.end(), 0.0f) / size;
+    std::array<float, 1> sum = compensated_sums<1>(v.size(), [&v](size_t i, std::array<float, 1> &s) {
+        s[0] += v[i];
+    });
+    return sum[0] / size;
 }
 
 /* also known as Pearson coefficient
@@ -22,26 +25,25 @@ float average(std::vector<float> &v) {
  * r = 0 => no relationship
  * etc.
  */
-float correlation_coefficient(std::vector<float> xs, std::vector<float> ys) {
+float correlation_coefficient(const std::vector<float> &xs, const std::vector<float> &ys) {
     float xAverage = average(xs);
     float yAverage = average(ys);
 
-    float numerator = 0;
-    for (size_t i = 0; i < xs.size(); i++) {
-        numerator += (xs[i] - xAverage) * (ys[i] - yAverage);
-    }
+    /* the numerator and both sums of squares in one pass */
+    std::array<float, 3> sums = compensated_sums<3>(xs.size(), [&](size_t i, std::array<float, 3> &s) {
+        float dx = xs[i] - xAverage;
+        float dy = ys[i] - yAverage;
 
-    float denominator;
+        s[0] += dx * dy;
+        s[1] += dx * dx;
+        s[2] += dy * dy;
+    });
 
-    float leftSum = 0;
-    for (size_t j = 0; j < xs.size(); j++) {
-        leftSum += std::pow(xs[j] - xAverage, 2);
-    }
+    float numerator = sums[0];
+    float leftSum = sums[1];
+    float rightSum = sums[2];
 
-    float rightSum = 0;
-    for (size_t k = 0; k < ys.size(); k++) {
-        rightSum += std::pow(ys[k] - yAverage, 2);
-    }
+    float denominator;
 
     denominator = std::sqrt(leftSum * rightSum);
 
@@ -67,22 +69,7 @@ float deviation_lineal(float a, float b, std::vector<float> &xs, std::vector<flo
      * ∑[1, n](φ(x_i) - y_i)^2 = ∑[1, n](a*x_i + b - y_i)^2 -> min
      * */
 
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * x + b;
-    };
-
-    float S = 0;
-    std::vector<float> y_phi; y_phi.reserve(xs.size());
-
-    for (float x : xs) {
-        y_phi.push_back(phi_of_x(x));
-    }
-
-    for (size_t i = 0; i < y_phi.size(); i++) {
-        S += std::pow(y_phi[i] - ys[i], 2);
-    }
-
-    return S;
+    return sse_polynomial(std::array<float, 2>{b, a}.data(), 1, xs.data(), ys.data(), xs.size());
 }
 
 float deviation_exponential(float a, float b, std::vector<float> &xs, std::vector<float> &ys) {
@@ -95,97 +82,35 @@ float deviation_exponential(float a, float b, std::vector<float> &xs, std::vecto
      * least squares function: S = S(a, b) = ∑[1, n](ε_i^2) =
      * ∑[1, n](φ(x_i) - y_i)^2 = ∑[1, n](a*x_i + b - y_i)^2 -> min
      * */
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * std::exp(b * x);
-    };
-
-    float S = 0;
-    std::vector<float> y_phi; y_phi.reserve(xs.size());
-
-    for (float x : xs) {
-        y_phi.push_back(phi_of_x(x));
-    }
-
-    for (size_t i = 0; i < y_phi.size(); i++) {
-        S += std::pow(y_phi[i] - ys[i], 2);
-    }
-
-    return S;
+    return sse_exponential(a, b, xs.data(), ys.data(), xs.size());
 }
 
-//TODO: add comments
 float deviation_power(float a, float b, std::vector<float> &xs, std::vector<float> &ys) {
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * std::pow(x, b);
-    };
-
-    float S = 0;
-    std::vector<float> y_phi; y_phi.reserve(xs.size());
-
-    for (float x : xs) {
-        y_phi.push_back(phi_of_x(x));
-    }
-
-    for (size_t i = 0; i < y_phi.size(); i++) {
-        S += std::pow(y_phi[i] - ys[i], 2);
-    }
-
-    return S;
+    /* φ(x) = a * x^b */
+    return sse_power(a, b, xs.data(), ys.data(), xs.size());
 }
 
 float deviation_log(float a, float b, std::vector<float> &xs, std::vector<float> &ys) {
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * std::log(x) + b;
-    };
-
-    float S = 0;
-    std::vector<float> y_phi; y_phi.reserve(xs.size());
-
-    for (float x : xs) {
-        y_phi.push_back(phi_of_x(x));
-    }
-
-    for (size_t i = 0; i < y_phi.size(); i++) {
-        S += std::pow(y_phi[i] - ys[i], 2);
-    }
-
-    return S;
+    /* φ(x) = a * ln(x) + b */
+    return sse_log(a, b, xs.data(), ys.data(), xs.size());
 }
 
 float deviation_quadratic(float a_0, float a_1, float a_2, std::vector<float> &xs, std::vector<float> &ys) {
-    auto phi_of_x = [a_0, a_1, a_2](float x) -> float {
-        return a_2 * std::pow(x, 2) + a_1 * std::pow(x, 1) + a_0 * std::pow(x, 0);
-    };
-
-    float S = 0;
-    std::vector<float> y_phi; y_phi.reserve(xs.size());
-
-    for (float x : xs) {
-        y_phi.push_back(phi_of_x(x));
-    }
-
-    for (size_t i = 0; i < y_phi.size(); i++) {
-        S += std::pow(y_phi[i] - ys[i], 2);
-    }
-
-    return S;
+    /* φ(x) = a_0 + a_1 * x + a_2 * x^2 */
+    return sse_polynomial(std::array<float, 3>{a_0, a_1, a_2}.data(), 2, xs.data(), ys.data(), xs.size());
 }
 
 float deviation_qube(float a_0, float a_1, float a_2, float a_3, std::vector<float> &xs, std::vector<float> &ys) {
-    auto phi_of_x = [a_0, a_1, a_2, a_3](float x) -> float {
-        return a_3 * std::pow(x, 3) + a_2 * std::pow(x, 2) + a_1 * std::pow(x, 1) + a_0 * std::pow(x, 0);
-    };
-
-    float S = 0;
-    std::vector<float> y_phi; y_phi.reserve(xs.size());
-
-    for (float x : xs) {
-        y_phi.push_back(phi_of_x(x));
-    }
+    /* φ(x) = a_0 + a_1 * x + a_2 * x^2 + a_3 * x^3 */
+    return sse_polynomial(std::array<float, 4>{a_0, a_1, a_2, a_3}.data(), 3, xs.data(), ys.data(), xs.size());
+}
 
-    for (size_t i = 0; i < y_phi.size(); i++) {
-        S += std::pow(y_phi[i] - ys[i], 2);
+float deviation_polynomial(const Polynomial &p, const std::vector<float> &xs, const std::vector<float> &ys) {
+    /* φ(x) = b_0 + b_1 * t + ... + b_m * t^m, as returned by polynomial_approximation */
+    if (p.coefficients.empty()) {
+        throw std::runtime_error("Polynomial has no coefficients!");
     }
 
-    return S;
+    return sse_polynomial(p.coefficients.data(), p.degree(), static_cast<float>(p.scaling.center),
+                          p.scaling.inverse(), xs.data(), ys.data(), xs.size());
 }
\ No newline at end of file
@@ -4,10 +4,15 @@
 #include <vector>
 #include <numeric>
 #include <complex>
+#include <array>
+#include <stdexcept>
 
-float average(std::vector<float> &v);
+#include "kernels.h"
+#include "polynomial.h"
 
-float correlation_coefficient(std::vector<float> xs, std::vector<float> ys);
+float average(const std::vector<float> &v);
+
+float correlation_coefficient(const std::vector<float> &xs, const std::vector<float> &ys);
 
 float standard_deviation(float S, size_t n);
 
@@ -23,4 +28,6 @@ float deviation_quadratic(float a_0, float a_1, float a_2, std::vector<float> &x
 
 float deviation_qube(float a_0, float a_1, float a_2, float a_3, std::vector<float> &xs, std::vector<float> &ys);
 
+float deviation_polynomial(const Polynomial &p, const std::vector<float> &xs, const std::vector<float> &ys);
+
 #endif //FUNCTION_APPROXIMATION_DEVIATION_H
@@ -0,0 +1,122 @@
+#include "diagnostics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "deviation.h"
+
+float polynomial_sse(const FitResult &fit, const Moments &moments) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const std::vector<float> &cf = fit.coefficients;
+
+    double c[4];
+    size_t degree = 0;
+    switch (fit.model) {
+        case Model::Lineal:
+            if (cf.empty()) {
+                return nan;
+            }
+            /* a * x + b with x = center + scale * t */
+            c[0] = cf[1] + static_cast<double>(cf[0]) * moments.scaling.center;
+            c[1] = static_cast<double>(cf[0]) * moments.scaling.scale;
+            degree = 1;
+            break;
+        case Model::Quadratic:
+        case Model::Qube:
+            if (cf.empty() || fit.scaling.center != moments.scaling.center
+                || fit.scaling.scale != moments.scaling.scale) {
+                return nan;
+            }
+            std::copy(cf.begin(), cf.end(), c);
+            degree = cf.size() - 1;
+            break;
+        default:
+            return nan;
+    }
+
+    if (degree > moments.degree) {
+        return nan;
+    }
+
+    double S = moments.syy;
+    double root = std::sqrt(moments.syy);
+    for (size_t j = 0; j <= degree; j++) {
+        S -= 2 * c[j] * moments.sxy[j];
+
+        /* the quadratic form is symmetric: the diagonal once, every other term twice */
+        double row = c[j] * moments.sx[2 * j];
+        for (size_t k = j + 1; k <= degree; k++) {
+            row += 2 * c[k] * moments.sx[j + k];
+        }
+        S += c[j] * row;
+
+        root += std::abs(c[j]) * std::sqrt(moments.sx[2 * j]);
+    }
+
+    double n = static_cast<double>(moments.n);
+    double bound = (n + 2 * static_cast<double>(degree) + 4) * std::numeric_limits<double>::epsilon() * root * root;
+    if (!(bound <= std::numeric_limits<float>::epsilon() * S)) {
+        return nan;
+    }
+
+    return static_cast<float>(S);
+}
+
+float correlation_coefficient(const Moments &moments) {
+    if (moments.degree < 1) {
+        throw std::runtime_error("Pearson's coefficient needs the moments of x!");
+    }
+
+    double n = static_cast<double>(moments.n);
+    double sx = moments.sx[1];
+    double sy = moments.sxy[0];
+
+    double numerator = n * moments.sxy[1] - sx * sy;
+    double denominator = std::sqrt((n * moments.sx[2] - sx * sx) * (n * moments.syy - sy * sy));
+
+    if (!(denominator > 0)) {
+        throw std::runtime_error("While processing Pearson's coefficient dominator become 0!");
+    }
+
+    return static_cast<float>(numerator / denominator);
+}
+
+Diagnostics diagnose(float sse, size_t parameters, const Moments &moments) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    double n = static_cast<double>(moments.n);
+    double p = static_cast<double>(parameters);
+    double sy = moments.sxy.empty() ? 0.0 : moments.sxy[0];
+    double total = moments.syy - sy * sy / n;
+
+    Diagnostics d;
+    d.sse = sse;
+    d.standardDeviation = standard_deviation(sse, moments.n);
+
+    if (total > 0) {
+        d.rSquared = static_cast<float>(1.0 - sse / total);
+    } else {
+        d.rSquared = nan;
+    }
+
+    if (total > 0 && n > p) {
+        d.adjustedRSquared = static_cast<float>(1.0 - (sse / total) * (n - 1) / (n - p));
+    } else {
+        d.adjustedRSquared = nan;
+    }
+
+    /* ln(S / n) is -inf for an exact fit: every model that fits exactly would tie at -inf, so none is ranked */
+    if (sse > 0 && std::isfinite(sse) && n > 0) {
+        double logLikelihood = n * std::log(sse / n);
+        d.aic = static_cast<float>(logLikelihood + 2 * p);
+        d.bic = static_cast<float>(logLikelihood + p * std::log(n));
+    } else {
+        d.aic = nan;
+        d.bic = nan;
+    }
+
+    return d;
+}
+
@@ -0,0 +1,53 @@
+#ifndef FUNCTION_APPROXIMATION_DIAGNOSTICS_H
+#define FUNCTION_APPROXIMATION_DIAGNOSTICS_H
+
+#include <cstddef>
+
+#include "model.h"
+#include "moments.h"
+
+/*
+ * Quality measures of a fit, all of them functions of S, n and the number of coefficients p:
+ *
+ * R²           = 1 - S / Σ(y_i - ȳ)^2             share of the variance of y the fit explains
+ * adjusted R²  = 1 - (1 - R²) * (n - 1) / (n - p)  the same, charged for every coefficient
+ * AIC          = n * ln(S / n) + 2 * p             Gaussian errors, the constant terms left out,
+ * BIC          = n * ln(S / n) + p * ln(n)         so only differences between fits mean something
+ *
+ * Σ(y_i - ȳ)^2 = Σy^2 - (Σy)^2 / n comes from the moments, so given S they cost O(1) for any model.
+ * For the polynomial models S itself can come from the moments as well (polynomial_sse).
+ * A measure that is undefined is nan: R² when y is constant, adjusted R² when n <= p, AIC and BIC
+ * when S = 0 (an exact fit, ln 0) or S is not known.
+ */
+struct Diagnostics {
+    float sse = 0;
+    float standardDeviation = 0;
+    float rSquared = 0;
+    float adjustedRSquared = 0;
+    float aic = 0;
+    float bic = 0;
+};
+
+/*
+ * S = Σ(φ(x_i) - y_i)^2 of a lineal, quadratic or cube fit from the moments alone, O(degree^2):
+ *
+ * S = Σy^2 - 2 * Σ[k] c_k * Σt^k*y + Σ[j, k] c_j * c_k * Σt^(j+k)
+ *
+ * with c the coefficients of t of the moments (the line is taken into t first, the quadratic and the cube
+ * have to be in the scaling of the moments). S is what is left of terms as large as
+ * M = (sqrt(Σy^2) + Σ|c_k| * sqrt(Σt^2k))^2, and the double sums of n points and the formula are off
+ * by at most (n + 2 * degree + 4) * ε of M. Where that is within float ε of S (a fit far from exact,
+ * n up to some 10^5 for S a thousandth of Σy^2) the result is as good as a pass over the points;
+ * near an exact fit, with y far from 0 against the noise or over many millions of points it is not,
+ * and the result is nan. It is nan as well for a fit without coefficients, of another model or
+ * a higher degree than the moments.
+ */
+float polynomial_sse(const FitResult &fit, const Moments &moments);
+
+/* Pearson's r of x and y, O(1); throws when x or y is constant */
+float correlation_coefficient(const Moments &moments);
+
+/* the measures of a fit with S = sse and the given number of coefficients */
+Diagnostics diagnose(float sse, size_t parameters, const Moments &moments);
+
+#endif //FUNCTION_APPROXIMATION_DIAGNOSTICS_H
@@ -5,12 +5,7 @@
 #include "process.h"
 #include <sciplot/sciplot.hpp>
 
-void plotAllGraphs(std::vector<float> &xs, std::vector<float> &ys);
-
-void plotIfYNeg(std::vector<float> &xs, std::vector<float> &ys);
-
-void plotIfXNeg(std::vector<float> &xs, std::vector<float> &ys);
-
-void plotIfXAndYNeg(std::vector<float> &xs, std::vector<float> &ys);
+/* draws the points and the curve of every fit produced by the process stage, nothing is refitted here */
+void plotGraphs(std::vector<float> &xs, std::vector<float> &ys, const std::vector<FitResult> &fits);
 
 #endif //FUNCTION_APPROXIMATION_GRAPH_H
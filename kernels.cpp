@@ -0,0 +1,233 @@
+#include "kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "profile.h"
+#include "simd.h"
+#include "summation.h"
+#include "vecmath.h"
+
+namespace {
+    using namespace simd;
+
+    /*
+     * generic S = Σ(φ(x_i) - y_i)^2 driver:
+     * phi_vec evaluates φ over a whole vector, phi evaluates it for the remaining tail points
+     */
+    template<typename PhiVec, typename Phi>
+    float sum_of_squares(const float *xs, const float *ys, size_t n, PhiVec phi_vec, Phi phi) {
+        static_assert(SUM_BLOCK % WIDTH == 0, "summation blocks must hold whole vectors");
+
+        /* every lane sums a block in plain float, the block sums are added up compensated */
+        VecSum total;
+        size_t vectorEnd = n - n % WIDTH;
+
+        size_t i = 0;
+        while (i < vectorEnd) {
+            size_t end = std::min(vectorEnd, i + SUM_BLOCK);
+
+            /* two accumulators, so consecutive vectors do not wait for each other's fmadd */
+            Vec acc0 = set1(0.0f);
+            Vec acc1 = set1(0.0f);
+            for (; i + 2 * WIDTH <= end; i += 2 * WIDTH) {
+                Vec e0 = sub(phi_vec(load(xs + i)), load(ys + i));
+                Vec e1 = sub(phi_vec(load(xs + i + WIDTH)), load(ys + i + WIDTH));
+                acc0 = fmadd(e0, e0, acc0);
+                acc1 = fmadd(e1, e1, acc1);
+            }
+            for (; i < end; i += WIDTH) {
+                Vec e = sub(phi_vec(load(xs + i)), load(ys + i));
+                acc0 = fmadd(e, e, acc0);
+            }
+            total.add(add(acc0, acc1));
+        }
+
+        float tail = 0;
+        for (; i < n; i++) {
+            float e = phi(xs[i]) - ys[i];
+            tail = std::fma(e, e, tail);
+        }
+
+        CompensatedSum S = total.total();
+        S.add(tail);
+        return S.value();
+    }
+
+    /* same as sum_of_squares, but ε_i = φ(x_i) - y_i is stored instead of being accumulated */
+    template<typename PhiVec, typename Phi>
+    void store_residuals(const float *xs, const float *ys, float *out, size_t n, PhiVec phi_vec, Phi phi) {
+        size_t i = 0;
+        for (; i + WIDTH <= n; i += WIDTH) {
+            store(out + i, sub(phi_vec(load(xs + i)), load(ys + i)));
+        }
+
+        for (; i < n; i++) {
+            out[i] = phi(xs[i]) - ys[i];
+        }
+    }
+
+    /* every model is described by a pair (vector φ, scalar φ) that both drivers share */
+    auto polynomial(const float *c, size_t degree, float center = 0, float inverse = 1) {
+        /* Horner's scheme in t = (x - center) * inverse: φ = (...(c_m * t + c_(m-1)) * t + ...) * t + c_0 */
+        auto phi_vec = [c, degree, center, inverse](Vec x) -> Vec {
+            Vec t = mul(sub(x, set1(center)), set1(inverse));
+            Vec p = set1(c[degree]);
+            for (size_t k = degree; k-- > 0;) {
+                p = fmadd(p, t, set1(c[k]));
+            }
+            return p;
+        };
+
+        auto phi = [c, degree, center, inverse](float x) -> float {
+            float t = (x - center) * inverse;
+            float p = c[degree];
+            for (size_t k = degree; k-- > 0;) {
+                p = std::fma(p, t, c[k]);
+            }
+            return p;
+        };
+
+        return std::make_pair(phi_vec, phi);
+    }
+
+    auto exponential(float a, float b) {
+        auto phi_vec = [a, b](Vec x) -> Vec {
+            return mul(set1(a), vexp(mul(set1(b), x)));
+        };
+
+        auto phi = [a, b](float x) -> float {
+            return a * sexp(b * x);
+        };
+
+        return std::make_pair(phi_vec, phi);
+    }
+
+    auto power(float a, float b) {
+        auto phi_vec = [a, b](Vec x) -> Vec {
+            return mul(set1(a), vpow(x, b));
+        };
+
+        auto phi = [a, b](float x) -> float {
+            return a * spow(x, b);
+        };
+
+        return std::make_pair(phi_vec, phi);
+    }
+
+    auto logarithmic(float a, float b) {
+        auto phi_vec = [a, b](Vec x) -> Vec {
+            return fmadd(set1(a), vlog(x), set1(b));
+        };
+
+        auto phi = [a, b](float x) -> float {
+            return std::fma(a, slog(x), b);
+        };
+
+        return std::make_pair(phi_vec, phi);
+    }
+}
+
+const char *kernels_isa() {
+    return ISA;
+}
+
+float sse_polynomial(const float *c, size_t degree, const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("sse_polynomial");
+    PROFILE_COUNT("points", n);
+
+    auto phi = polynomial(c, degree);
+    return sum_of_squares(xs, ys, n, phi.first, phi.second);
+}
+
+float sse_polynomial(const float *c, size_t degree, float center, float inverse, const float *xs, const float *ys,
+                     size_t n) {
+    PROFILE_SCOPE("sse_polynomial");
+    PROFILE_COUNT("points", n);
+
+    auto phi = polynomial(c, degree, center, inverse);
+    return sum_of_squares(xs, ys, n, phi.first, phi.second);
+}
+
+float sse_exponential(float a, float b, const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("sse_exponential");
+    PROFILE_COUNT("points", n);
+
+    auto phi = exponential(a, b);
+    return sum_of_squares(xs, ys, n, phi.first, phi.second);
+}
+
+float sse_power(float a, float b, const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("sse_power");
+    PROFILE_COUNT("points", n);
+
+    auto phi = power(a, b);
+    return sum_of_squares(xs, ys, n, phi.first, phi.second);
+}
+
+float sse_log(float a, float b, const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("sse_log");
+    PROFILE_COUNT("points", n);
+
+    auto phi = logarithmic(a, b);
+    return sum_of_squares(xs, ys, n, phi.first, phi.second);
+}
+
+float sse_power_ln(float a, float b, const float *lnXs, const float *ys, size_t n) {
+    PROFILE_SCOPE("sse_power");
+    PROFILE_COUNT("points", n);
+
+    auto phi = exponential(a, b);
+    return sum_of_squares(lnXs, ys, n, phi.first, phi.second);
+}
+
+float sse_log_ln(float a, float b, const float *lnXs, const float *ys, size_t n) {
+    PROFILE_SCOPE("sse_log");
+    PROFILE_COUNT("points", n);
+
+    const float c[] = {b, a};
+    auto phi = polynomial(c, 1);
+    return sum_of_squares(lnXs, ys, n, phi.first, phi.second);
+}
+
+void residuals_polynomial(const float *c, size_t degree, const float *xs, const float *ys, float *out, size_t n) {
+    PROFILE_SCOPE("residuals_polynomial");
+    PROFILE_COUNT("points", n);
+
+    auto phi = polynomial(c, degree);
+    store_residuals(xs, ys, out, n, phi.first, phi.second);
+}
+
+void residuals_polynomial(const float *c, size_t degree, float center, float inverse, const float *xs,
+                          const float *ys, float *out, size_t n) {
+    PROFILE_SCOPE("residuals_polynomial");
+    PROFILE_COUNT("points", n);
+
+    auto phi = polynomial(c, degree, center, inverse);
+    store_residuals(xs, ys, out, n, phi.first, phi.second);
+}
+
+void residuals_exponential(float a, float b, const float *xs, const float *ys, float *out, size_t n) {
+    PROFILE_SCOPE("residuals_exponential");
+    PROFILE_COUNT("points", n);
+
+    auto phi = exponential(a, b);
+    store_residuals(xs, ys, out, n, phi.first, phi.second);
+}
+
+void residuals_power(float a, float b, const float *xs, const float *ys, float *out, size_t n) {
+    PROFILE_SCOPE("residuals_power");
+    PROFILE_COUNT("points", n);
+
+    auto phi = power(a, b);
+    store_residuals(xs, ys, out, n, phi.first, phi.second);
+}
+
+void residuals_log(float a, float b, const float *xs, const float *ys, float *out, size_t n) {
+    PROFILE_SCOPE("residuals_log");
+    PROFILE_COUNT("points", n);
+
+    auto phi = logarithmic(a, b);
+    store_residuals(xs, ys, out, n, phi.first, phi.second);
+}
@@ -0,0 +1,59 @@
+#ifndef FUNCTION_APPROXIMATION_KERNELS_H
+#define FUNCTION_APPROXIMATION_KERNELS_H
+
+#include <cstddef>
+
+/*
+ * Sum of squared residuals S = Σ[1, n](φ(x_i) - y_i)^2 for every kind of approximating function.
+ *
+ * The kernels are vectorized with AVX2 + FMA, SSE2 or NEON, whichever the target was compiled for,
+ * and fall back to plain scalar code otherwise. Polynomials are evaluated by Horner's scheme,
+ * so no std::pow is involved. For exp, power and log the transcendentals are the vector ones
+ * of vecmath.h (within a few ulp of libm, see there for the bounds), so all of φ and the accumulation
+ * of S stay in vector registers.
+ */
+
+/* name of the instruction set the kernels were built for: "avx2", "sse2", "neon" or "scalar" */
+const char *kernels_isa();
+
+/* φ(x) = c[0] + c[1]*x + ... + c[degree]*x^degree */
+float sse_polynomial(const float *c, size_t degree, const float *xs, const float *ys, size_t n);
+
+/* the same in t = (x - center) * inverse, the variable of the polynomial fits (see Polynomial) */
+float sse_polynomial(const float *c, size_t degree, float center, float inverse, const float *xs, const float *ys,
+                     size_t n);
+
+/* φ(x) = a * exp(b * x) */
+float sse_exponential(float a, float b, const float *xs, const float *ys, size_t n);
+
+/* φ(x) = a * x^b */
+float sse_power(float a, float b, const float *xs, const float *ys, size_t n);
+
+/* φ(x) = a * ln(x) + b */
+float sse_log(float a, float b, const float *xs, const float *ys, size_t n);
+
+/*
+ * S of power and log from ln x taken beforehand (see log_columns.h): x^b = e^(b * ln x),
+ * and a * ln(x) + b is a line in ln x, so the log model needs no transcendental at all
+ */
+float sse_power_ln(float a, float b, const float *lnXs, const float *ys, size_t n);
+
+float sse_log_ln(float a, float b, const float *lnXs, const float *ys, size_t n);
+
+/*
+ * The sse_* kernels never materialize φ(x_i) or the residuals.
+ * When a caller does need them, the residuals_* functions write ε_i = φ(x_i) - y_i into a buffer
+ * of n floats supplied by the caller.
+ */
+void residuals_polynomial(const float *c, size_t degree, const float *xs, const float *ys, float *out, size_t n);
+
+void residuals_polynomial(const float *c, size_t degree, float center, float inverse, const float *xs,
+                          const float *ys, float *out, size_t n);
+
+void residuals_exponential(float a, float b, const float *xs, const float *ys, float *out, size_t n);
+
+void residuals_power(float a, float b, const float *xs, const float *ys, float *out, size_t n);
+
+void residuals_log(float a, float b, const float *xs, const float *ys, float *out, size_t n);
+
+#endif //FUNCTION_APPROXIMATION_KERNELS_H
@@ -0,0 +1,56 @@
+#include "log_columns.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "profile.h"
+#include "simd.h"
+#include "vecmath.h"
+
+namespace {
+    bool allPositive(const float *values, size_t n) {
+        return std::all_of(values, values + n, [](float v) { return v > 0; });
+    }
+}
+
+LogColumns compute_log_columns(const std::vector<float> &xs, const std::vector<float> &ys) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+
+    return compute_log_columns(xs.data(), ys.data(), xs.size());
+}
+
+LogColumns compute_log_columns(const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("compute_log_columns");
+    PROFILE_COUNT("points", n);
+
+    LogColumns columns;
+    columns.n = n;
+
+    if (allPositive(xs, n)) {
+        columns.lnX.resize(n);
+        log_column(xs, columns.lnX.data(), n);
+    }
+
+    if (allPositive(ys, n)) {
+        columns.lnY.resize(n);
+        log_column(ys, columns.lnY.data(), n);
+    }
+
+    return columns;
+}
+
+void log_column(const float *values, float *out, size_t n) {
+    using namespace simd;
+
+    size_t i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+        store(out + i, vlog(load(values + i)));
+    }
+
+    for (; i < n; i++) {
+        out[i] = slog(values[i]);
+    }
+}
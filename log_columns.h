@@ -0,0 +1,37 @@
+#ifndef FUNCTION_APPROXIMATION_LOG_COLUMNS_H
+#define FUNCTION_APPROXIMATION_LOG_COLUMNS_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * ln(x) and ln(y) of a data set, taken once and read by everything that works with them:
+ * the linearized exp fit reads ln y, power reads ln x and ln y, log reads ln x, and so do the S passes
+ * of power (x^b = e^(b * ln x)) and log and the power refinement. Without the columns every one of
+ * them takes its own logarithms of the same points.
+ *
+ * A column is taken only when all its values are positive, otherwise it stays empty and the fits
+ * that need it refuse to run, like the ones on LogMoments do.
+ */
+struct LogColumns {
+    size_t n = 0;
+    std::vector<float> lnX;
+    std::vector<float> lnY;
+
+    bool hasLnX() const {
+        return lnX.size() == n;
+    }
+
+    bool hasLnY() const {
+        return lnY.size() == n;
+    }
+};
+
+LogColumns compute_log_columns(const std::vector<float> &xs, const std::vector<float> &ys);
+
+LogColumns compute_log_columns(const float *xs, const float *ys, size_t n);
+
+/* out[i] = ln(values[i]) for n values, a vector at a time */
+void log_column(const float *values, float *out, size_t n);
+
+#endif //FUNCTION_APPROXIMATION_LOG_COLUMNS_H
@@ -1,15 +1,16 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
-#include <sstream>
+#include <memory>
 
 #include "approximation.h"
 #include "process.h"
 #include "deviation.h"
 #include "util.h"
 #include "graph.h"
-
-typedef std::pair<std::vector<float>, std::vector<float>> Points;
+#include "points_file.h"
+#include "batch.h"
+#include "profile.h"
 
 void labInfo() {
     std::cout << "==============================" << std::endl;
@@ -19,141 +20,172 @@ void labInfo() {
     std::cout << "==============================" << std::endl;
 }
 
-Points readFunctionPointsFromFile(std::string &fileName) {
-    std::ifstream file(fileName);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open the file!");
+int main(int argc, char **argv) {
+    std::string fileName = "test.txt";
+    std::string batchFile;
+    std::string manifestFile;
+    std::string outputFile;
+    std::string format;
+    size_t tableRows = 0;
+    bool parallel = false;
+    bool refine = false;
+    bool validate = false;
+    size_t folds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--parallel") {
+            parallel = true;
+        } else if (arg == "--refine") {
+            refine = true;
+        } else if (arg == "--convert") {
+            if (i + 2 >= argc) {
+                throw std::runtime_error("Usage: --convert <text file> <binary file>");
+            }
+
+            convertTextToBinary(argv[i + 1], argv[i + 2]);
+            return 0;
+        } else if (arg == "--format") {
+            if (i + 1 >= argc || (std::string(argv[i + 1]) != "json" && std::string(argv[i + 1]) != "csv")) {
+                throw std::runtime_error("Usage: --format json|csv");
+            }
+
+            format = argv[++i];
+        } else if (arg == "--table-rows") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Usage: --table-rows <rows>");
+            }
+
+            tableRows = std::stoul(argv[++i]);
+        } else if (arg == "--cv") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Usage: --cv <folds>|loo");
+            }
+
+            std::string value = argv[++i];
+            validate = true;
+            folds = value == "loo" ? 0 : std::stoul(value);
+        } else if (arg == "--profile") {
+            if (i + 1 >= argc || (std::string(argv[i + 1]) != "text" && std::string(argv[i + 1]) != "json")) {
+                throw std::runtime_error("Usage: --profile text|json");
+            }
+
+            profile::enable(std::string(argv[++i]) == "json" ? profile::Format::Json : profile::Format::Text);
+        } else if (arg == "--batch" || arg == "--manifest" || arg == "--output") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Usage: " + arg + " <file>");
+            }
+
+            std::string &target = arg == "--batch" ? batchFile : arg == "--manifest" ? manifestFile : outputFile;
+            target = argv[++i];
+        } else {
+            fileName = arg;
+        }
     }
 
-    std::string line;
-    std::getline(file, line);
+    if (!batchFile.empty() || !manifestFile.empty()) {
+        std::vector<Series> series = batchFile.empty() ? readManifest(manifestFile) : readSeriesFile(batchFile);
 
-    std::istringstream xs_stream(line);
-    std::vector<float> xs;
+        std::ofstream output;
+        if (!outputFile.empty()) {
+            output.open(outputFile);
+            if (!output.is_open()) {
+                throw std::runtime_error("Cannot open the output file!");
+            }
+        }
 
-    float x;
-    while (xs_stream >> x) {
-        xs.push_back(x);
-    }
+        BatchSummary summary = runBatch(series, outputFile.empty() ? std::cout : output, parallel ? 0 : 1,
+                                        refine);
 
-    std::getline(file, line);
-    std::istringstream ysStream(line);
-    std::vector<float> ys;
+        std::cerr << "batch: " << summary.series << " series (" << summary.points << " points) in "
+                  << summary.seconds << " s, " << summary.series / std::max(summary.seconds, 1e-9)
+                  << " series/sec" << std::endl;
+        return 0;
+    }
 
-    float y;
-    while (ysStream >> y) {
-        ys.push_back(y);
+    if (format.empty()) {
+        labInfo();
     }
 
-    return {xs, ys};
-}
+    /* a binary file is mapped and fitted in place, a text file is parsed into points */
+    std::unique_ptr<MappedPoints> mapped;
+    FunctionPoints points;
 
-int main() {
-    labInfo();
+    if (isBinaryPointsFile(fileName)) {
+        mapped = std::make_unique<MappedPoints>(fileName);
+    } else {
+        points = readFunctionPointsFromFile(fileName);
 
-    std::string fileName = "test.txt";
+        if (points.first.size() != points.second.size()) {
+            throw std::runtime_error("The number of points x and y don't match!");
+        }
+    }
 
-    std::pair<std::vector<float>, std::vector<float>> points = readFunctionPointsFromFile(fileName);
+    const float *xs = mapped ? mapped->xs() : points.first.data();
+    const float *ys = mapped ? mapped->ys() : points.second.data();
+    size_t n = mapped ? mapped->size() : points.first.size();
 
-    if (points.first.size() != points.second.size()) {
-        throw std::runtime_error("The number of points x and y don't match!");
-    }
+    bool isNegativeX = hasNegativeNumber(xs, n);
+    bool isNegativeY = hasNegativeNumber(ys, n);
 
+    /* moments of degree 3 cover the lineal, quadratic and cube fits, so the data is scanned once for all of them */
+    Moments moments = compute_moments(xs, ys, n, 3);
 
-    std::vector<float> xs = points.first;
-    std::vector<float> ys = points.second;
+    /* and ln x, ln y once for the power, exp and log fits */
+    LogColumns logs = compute_log_columns(xs, ys, n);
 
-    bool isNegativeX = hasNegativeNumber(xs);
-    bool isNegativeY = hasNegativeNumber(ys);
+    std::vector<Model> models = candidateModels(isNegativeX, isNegativeY);
 
-    std::vector<float> result;
-    if (isNegativeX && isNegativeY) {
-        result.push_back(process_lineal(xs, ys));
-        result.push_back(process_quadratic(xs, ys));
-        result.push_back(process_qube(xs, ys));
+    /* quiet mode: coefficients and deviations only, no tables and no plot */
+    if (!format.empty()) {
+        std::vector<FitResult> fits = fit_models(models, xs, ys, n, moments, logs, parallel, refine);
+        std::vector<CrossValidation> validations;
+        if (validate) {
+            validations = cross_validate(models, xs, ys, n, logs, folds);
+        }
+        write_fits(fits, moments, format == "json" ? OutputFormat::Json : OutputFormat::Csv, std::cout, validations);
+        return 0;
+    }
 
-        float minValue = * std::min_element(result.begin(), result.end());
+    /* the tables and the plot work on vectors, only they get a copy of the mapped columns */
+    if (mapped) {
+        points = {std::vector<float>(xs, xs + n), std::vector<float>(ys, ys + n)};
+    }
 
-        std::cout << "Best approx: " << minValue << std::endl;
+    std::vector<FitResult> result = process_models(models, points.first, points.second, moments, logs, parallel,
+                                                   std::cout, tableRows, refine);
 
-        if (minValue == result[0]) {
-            std::cout << "The best approximation is lineal" << std::endl;
-        } else if (minValue == result[1]) {
-            std::cout << "The best approximation is quadratic" << std::endl;
-        } else if (minValue == result[2]) {
-            std::cout << "The best approximation is qube" << std::endl;
-        }
+    /* every δ comes from the single scoring pass of process_models */
+    const FitResult *best = best_fit(result);
+    if (best == nullptr) {
+        throw std::runtime_error("No model could be fitted to the points!");
+    }
 
-        plotIfXAndYNeg(xs, ys);
-    } else if (isNegativeX) {
-        result.push_back(process_lineal(xs, ys));
-        result.push_back(process_quadratic(xs, ys));
-        result.push_back(process_qube(xs, ys));
-        result.push_back(process_exp(xs, ys));
-
-        float minValue = * std::min_element(result.begin(), result.end());
-
-        std::cout << "Best approx: " << minValue << std::endl;
-
-        if (minValue == result[0]) {
-            std::cout << "The best approximation is lineal" << std::endl;
-        } else if (minValue == result[1]) {
-            std::cout << "The best approximation is quadratic" << std::endl;
-        } else if (minValue == result[2]) {
-            std::cout << "The best approximation is qube" << std::endl;
-        } else if (minValue == result[3]) {
-            std::cout << "The best approximation is exp" << std::endl;
-        }
+    std::cout << "Best approx: " << best->standardDeviation << std::endl;
+    std::cout << "The best approximation is " << modelName(best->model) << std::endl;
 
-        plotIfXNeg(xs, ys);
-    } else if (isNegativeY) {
-        result.push_back(process_lineal(xs, ys));
-        result.push_back(process_quadratic(xs, ys));
-        result.push_back(process_qube(xs, ys));
-        result.push_back(process_log(xs, ys));
-
-        float minValue = *std::min_element(result.begin(), result.end());
-        std::cout << "Best approx: " << minValue << std::endl;
-
-        if (minValue == result[0]) {
-            std::cout << "The best approximation is lineal" << std::endl;
-        } else if (minValue == result[1]) {
-            std::cout << "The best approximation is quadratic" << std::endl;
-        } else if (minValue == result[2]) {
-            std::cout << "The best approximation is qube" << std::endl;
-        } else if (minValue == result[3]) {
-            std::cout << "The best approximation is log" << std::endl;
-        }
+    /* δ of the fit itself always favours the cube, the held out points do not */
+    if (validate) {
+        std::vector<CrossValidation> validations = cross_validate(models, xs, ys, n, logs, folds);
 
-        plotIfYNeg(xs, ys);
-    } else {
-        result.push_back(process_lineal(xs, ys));
-        result.push_back(process_quadratic(xs, ys));
-        result.push_back(process_qube(xs, ys));
-        result.push_back(process_power(xs, ys));
-        result.push_back(process_exp(xs, ys));
-        result.push_back(process_log(xs, ys));
-
-        float minValue = *std::min_element(result.begin(), result.end());
-
-        std::cout << "Best approx: " << minValue << std::endl;
-
-        if (minValue == result[0]) {
-            std::cout << "The best approximation is lineal" << std::endl;
-        } else if (minValue == result[1]) {
-            std::cout << "The best approximation is quadratic" << std::endl;
-        } else if (minValue == result[2]) {
-            std::cout << "The best approximation is qube" << std::endl;
-        } else if (minValue == result[3]) {
-            std::cout << "The best approximation is power" << std::endl;
-        } else if (minValue == result[4]) {
-            std::cout << "The best approximation is exp" << std::endl;
-        } else if (minValue == result[5]) {
-            std::cout << "The best approximation is log" << std::endl;
+        std::cout << std::endl;
+        std::cout << "Cross-validation, " << (folds == 0 ? std::string("leave-one-out")
+                                                         : std::to_string(folds) + " folds") << ":" << std::endl;
+        for (const CrossValidation &validation : validations) {
+            std::cout << "Cross-validated standard deviation for " << modelName(validation.model)
+                      << " approximation = " << validation.standardDeviation << std::endl;
         }
 
-        plotAllGraphs(xs, ys);
+        const CrossValidation *bestValidation = best_validation(validations);
+        if (bestValidation != nullptr) {
+            std::cout << "Best cross-validated approx: " << bestValidation->standardDeviation << std::endl;
+            std::cout << "The best cross-validated approximation is " << modelName(bestValidation->model)
+                      << std::endl;
+        }
     }
 
+    plotGraphs(points.first, points.second, result);
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,69 @@
+#include "model.h"
+
+#include <cmath>
+
+const char *modelName(Model model) {
+    switch (model) {
+        case Model::Lineal: return "lineal";
+        case Model::Quadratic: return "quadratic";
+        case Model::Qube: return "qube";
+        case Model::Power: return "power";
+        case Model::Exp: return "exp";
+        case Model::Log: return "log";
+    }
+
+    return "unknown";
+}
+
+float evaluate(const FitResult &fit, float x) {
+    const std::vector<float> &c = fit.coefficients;
+
+    switch (fit.model) {
+        case Model::Lineal:
+            return c[0] * x + c[1];
+        case Model::Quadratic:
+        case Model::Qube: {
+            float t = fit.scaling.t(x);
+            float p = c.back();
+            for (size_t k = c.size() - 1; k-- > 0;) {
+                p = p * t + c[k];
+            }
+            return p;
+        }
+        case Model::Power:
+            return c[0] * std::pow(x, c[1]);
+        case Model::Exp:
+            return c[0] * std::exp(c[1] * x);
+        case Model::Log:
+            return c[0] * std::log(x) + c[1];
+    }
+
+    return 0;
+}
+
+Polynomial polynomialOf(const FitResult &fit) {
+    return {fit.coefficients, fit.scaling};
+}
+
+std::vector<float> reportedCoefficients(const FitResult &fit) {
+    bool polynomial = fit.model == Model::Quadratic || fit.model == Model::Qube;
+    return polynomial && !fit.coefficients.empty() ? expanded(polynomialOf(fit)) : fit.coefficients;
+}
+
+std::vector<Model> candidateModels(bool isNegativeX, bool isNegativeY) {
+    std::vector<Model> models = {Model::Lineal, Model::Quadratic, Model::Qube};
+
+    if (isNegativeX && isNegativeY) {
+        return models;
+    } else if (isNegativeX) {
+        models.push_back(Model::Exp);
+    } else if (isNegativeY) {
+        models.push_back(Model::Log);
+    } else {
+        models.push_back(Model::Power);
+        models.push_back(Model::Exp);
+        models.push_back(Model::Log);
+    }
+
+    return models;
+}
@@ -0,0 +1,51 @@
+#ifndef FUNCTION_APPROXIMATION_MODEL_H
+#define FUNCTION_APPROXIMATION_MODEL_H
+
+#include <vector>
+
+#include "polynomial.h"
+
+/* candidate approximating functions, in the order they are processed and reported */
+enum class Model {
+    Lineal,
+    Quadratic,
+    Qube,
+    Power,
+    Exp,
+    Log
+};
+
+const char *modelName(Model model);
+
+/*
+ * everything the process stage learns about one model, so later stages (plotting) never refit it
+ *
+ * coefficients are in the order the approx_* function of the model returns them:
+ * lineal, power, exp, log - {a, b}; quadratic, qube - {b_0, b_1, ...} of t = (x - center) / scale (see Polynomial),
+ * scaling is the identity for the other models
+ */
+struct FitResult {
+    Model model = Model::Lineal;
+    std::vector<float> coefficients;
+    XScaling scaling = {};
+    float deviation = 0;            /* S = Σ[1, n](φ(x_i) - y_i)^2 */
+    float standardDeviation = 0;    /* δ = sqrt(S / n) */
+    float maxError = 0;             /* max |φ(x_i) - y_i| */
+};
+
+/* φ(x) of the fitted model */
+float evaluate(const FitResult &fit, float x);
+
+/* the fit of a polynomial model as a Polynomial */
+Polynomial polynomialOf(const FitResult &fit);
+
+/* the coefficients to show: those of x, expanded from t for quadratic and qube (see expanded) */
+std::vector<float> reportedCoefficients(const FitResult &fit);
+
+/*
+ * power and log need x > 0, exp and power need y > 0 (they are fitted in log space),
+ * so the set of candidates depends on the signs in the data
+ */
+std::vector<Model> candidateModels(bool isNegativeX, bool isNegativeY);
+
+#endif //FUNCTION_APPROXIMATION_MODEL_H
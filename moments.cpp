@@ -0,0 +1,185 @@
+#include "moments.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "profile.h"
+
+Moments compute_moments(const std::vector<float> &xs, const std::vector<float> &ys, size_t degree) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+
+    return compute_moments(xs.data(), ys.data(), xs.size(), degree);
+}
+
+namespace {
+    /*
+     * the sums of a degree known at compile time: t^0 .. t^(2 * Degree) are built by a fold over the index pack
+     * (as in PolyFit), so every sum is a register and the loop has no inner loop over the degree
+     */
+    template<size_t Degree, size_t... K>
+    void sumPowers(const float *xs, const float *ys, size_t n, Moments &m, std::index_sequence<K...>) {
+        double sx[2 * Degree + 1] = {};
+        double sxy[Degree + 1] = {};
+        double syy = 0;
+
+        const float center = static_cast<float>(m.scaling.center);
+        const float inverse = m.scaling.inverse();
+
+        for (size_t i = 0; i < n; i++) {
+            double t = (xs[i] - center) * inverse;
+            double y = ys[i];
+
+            double p[2 * Degree + 1];
+            p[0] = 1;
+            ((K > 0 ? (p[K] = p[K - 1] * t) : p[0]), ...);
+
+            syy += y * y;
+            ((sx[K] += p[K]), ...);
+            ((K <= Degree ? (sxy[K] += p[K] * y) : 0.0), ...);
+        }
+
+        m.n = n;
+        m.sx.assign(sx, sx + 2 * Degree + 1);
+        m.sxy.assign(sxy, sxy + Degree + 1);
+        m.syy = syy;
+    }
+
+    template<size_t Degree>
+    void sumPowers(const float *xs, const float *ys, size_t n, Moments &m) {
+        sumPowers<Degree>(xs, ys, n, m, std::make_index_sequence<2 * Degree + 1>{});
+    }
+}
+
+Moments compute_moments(const float *xs, const float *ys, size_t n, size_t degree) {
+    return compute_moments(xs, ys, n, degree, centered_scaling(xs, n));
+}
+
+Moments compute_moments(const float *xs, const float *ys, size_t n, size_t degree, const XScaling &scaling) {
+    PROFILE_SCOPE("compute_moments");
+    PROFILE_COUNT("points", n);
+
+    Moments m(degree, scaling);
+    switch (degree) {
+        case 0: sumPowers<0>(xs, ys, n, m); break;
+        case 1: sumPowers<1>(xs, ys, n, m); break;
+        case 2: sumPowers<2>(xs, ys, n, m); break;
+        case 3: sumPowers<3>(xs, ys, n, m); break;
+        case 4: sumPowers<4>(xs, ys, n, m); break;
+        case 5: sumPowers<5>(xs, ys, n, m); break;
+        case 6: sumPowers<6>(xs, ys, n, m); break;
+        case 7: sumPowers<7>(xs, ys, n, m); break;
+        case 8: sumPowers<8>(xs, ys, n, m); break;
+        case 9: sumPowers<9>(xs, ys, n, m); break;
+        case 10: sumPowers<10>(xs, ys, n, m); break;
+        default:
+            for (size_t i = 0; i < n; i++) {
+                m.add(xs[i], ys[i]);
+            }
+    }
+
+    return m;
+}
+
+void Moments::add(float x, float y) {
+    double t = scaling.t(x);
+    double p = 1;
+
+    syy += static_cast<double>(y) * y;
+    for (size_t k = 0; k <= degree; k++) {
+        sx[k] += p;
+        sxy[k] += p * y;
+        p *= t;
+    }
+
+    for (size_t k = degree + 1; k <= 2 * degree; k++) {
+        sx[k] += p;
+        p *= t;
+    }
+
+    n++;
+}
+
+void Moments::remove(float x, float y) {
+    if (n == 0) {
+        throw std::runtime_error("There are no points to remove!");
+    }
+
+    double t = scaling.t(x);
+    double p = 1;
+
+    syy -= static_cast<double>(y) * y;
+    for (size_t k = 0; k <= degree; k++) {
+        sx[k] -= p;
+        sxy[k] -= p * y;
+        p *= t;
+    }
+
+    for (size_t k = degree + 1; k <= 2 * degree; k++) {
+        sx[k] -= p;
+        p *= t;
+    }
+
+    n--;
+}
+
+void Moments::clear() {
+    n = 0;
+    std::fill(sx.begin(), sx.end(), 0.0);
+    std::fill(sxy.begin(), sxy.end(), 0.0);
+    syy = 0;
+}
+
+void LogMoments::add(float x, float y) {
+    n++;
+
+    sx += x;
+    sxx += static_cast<double>(x) * x;
+    sy += y;
+
+    bool hasLx = x > 0;
+    bool hasLy = y > 0;
+    float lx = hasLx ? std::log(x) : 0.0f;
+    float ly = hasLy ? std::log(y) : 0.0f;
+
+    if (hasLx) {
+        slx += lx;
+        slxlx += static_cast<double>(lx) * lx;
+        slxy += static_cast<double>(lx) * y;
+    } else {
+        nonPositiveX++;
+    }
+
+    if (hasLy) {
+        sly += ly;
+        sxly += static_cast<double>(x) * ly;
+    } else {
+        nonPositiveY++;
+    }
+
+    if (hasLx && hasLy) {
+        slxly += static_cast<double>(lx) * ly;
+    }
+}
+
+LogMoments compute_log_moments(const std::vector<float> &xs, const std::vector<float> &ys) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+
+    return compute_log_moments(xs.data(), ys.data(), xs.size());
+}
+
+LogMoments compute_log_moments(const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("compute_log_moments");
+    PROFILE_COUNT("points", n);
+
+    LogMoments l;
+    for (size_t i = 0; i < n; i++) {
+        l.add(xs[i], ys[i]);
+    }
+
+    return l;
+}
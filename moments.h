@@ -0,0 +1,97 @@
+#ifndef FUNCTION_APPROXIMATION_MOMENTS_H
+#define FUNCTION_APPROXIMATION_MOMENTS_H
+
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+#include "polynomial.h"
+
+/*
+ * Power sums of the data set, the only thing polynomial least squares needs from the points:
+ *
+ * sx[k]  = Σ[1, n](x_i^k),       k = 0 .. 2 * degree
+ * sxy[k] = Σ[1, n](x_i^k * y_i), k = 0 .. degree
+ * syy    = Σ[1, n](y_i^2)
+ *
+ * Moments of degree m are enough to build the normal system of any polynomial fit of degree <= m,
+ * so lineal, quadratic and cube approximations can share one set computed for degree 3.
+ * With syy they also give S of such a fit and the quality measures built on it (see diagnostics.h).
+ *
+ * The powers are those of t = (x - center) / scale of scaling (see polynomial.h), of x itself with the identity:
+ * compute_moments centers the data it is given, the streaming fitters keep the scaling they were made with.
+ * The polynomials fitted from the moments are in t, S and the other measures do not depend on it.
+ *
+ * The sums are double. A float running sum loses about n * ε of its value, so Σx^6 over millions of points
+ * has no correct digits left; a double one loses 2^29 times less, which is enough for any n we see.
+ * The per point work is the same either way: the adds of a sum depend on each other, so they run
+ * one after another whatever their width, and the double loop is as fast as the float one.
+ */
+struct Moments {
+    size_t n = 0;
+    size_t degree = 0;
+    XScaling scaling;
+    std::vector<double> sx;
+    std::vector<double> sxy;
+    double syy = 0;
+
+    /* empty sums, ready to have points added */
+    explicit Moments(size_t degree = 0, const XScaling &scaling = {})
+            : degree(degree), scaling(scaling), sx(2 * degree + 1, 0.0), sxy(degree + 1, 0.0) {}
+
+    /* adds the contribution of one more point, O(degree) */
+    void add(float x, float y);
+
+    /* takes back the contribution of a point added earlier, O(degree) */
+    void remove(float x, float y);
+
+    /* no points and all sums 0, the degree and the scaling stay */
+    void clear();
+};
+
+/*
+ * Sums of the linearized exp, power and log fits:
+ *
+ * exp:   ln(y) = ln(a) + b * x      needs Σx, Σx^2, Σln(y), Σx*ln(y)
+ * power: ln(y) = ln(a) + b * ln(x)  needs Σln(x), Σln(x)^2, Σln(y), Σln(x)*ln(y)
+ * log:   y = a * ln(x) + b          needs Σln(x), Σln(x)^2, Σy, Σln(x)*y
+ *
+ * Logarithms exist only for positive numbers, points with x <= 0 or y <= 0 are counted instead,
+ * and a fit that needs the missing logarithm refuses to run while such points are present.
+ * The sums are double like those of Moments, the logarithms themselves are taken in float.
+ */
+struct LogMoments {
+    size_t n = 0;
+    size_t nonPositiveX = 0;
+    size_t nonPositiveY = 0;
+
+    double sx = 0;
+    double sxx = 0;
+    double sy = 0;
+
+    double slx = 0;
+    double slxlx = 0;
+    double sly = 0;
+    double sxly = 0;
+    double slxly = 0;
+    double slxy = 0;
+
+    void add(float x, float y);
+};
+
+/*
+ * computes all the power sums up to the given degree in a single pass over xs and ys, O(n * degree),
+ * of t in the centered_scaling of xs (one more pass, over x alone)
+ */
+Moments compute_moments(const std::vector<float> &xs, const std::vector<float> &ys, size_t degree);
+
+Moments compute_moments(const float *xs, const float *ys, size_t n, size_t degree);
+
+/* the same in the given scaling */
+Moments compute_moments(const float *xs, const float *ys, size_t n, size_t degree, const XScaling &scaling);
+
+LogMoments compute_log_moments(const std::vector<float> &xs, const std::vector<float> &ys);
+
+LogMoments compute_log_moments(const float *xs, const float *ys, size_t n);
+
+#endif //FUNCTION_APPROXIMATION_MOMENTS_H
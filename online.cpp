@@ -0,0 +1,42 @@
+#include "online.h"
+
+OnlineFit::OnlineFit(size_t degree, const XScaling &scaling) : moments(degree, scaling) {
+    if (degree < 1 || degree > 10) {
+        throw std::runtime_error("Polynomial degree must be from 1 to 10!");
+    }
+}
+
+void OnlineFit::add(float x, float y) {
+    moments.add(x, y);
+    logMoments.add(x, y);
+}
+
+void OnlineFit::add(const std::vector<float> &xs, const std::vector<float> &ys) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+
+    for (size_t i = 0; i < xs.size(); i++) {
+        add(xs[i], ys[i]);
+    }
+}
+
+std::pair<float, float> OnlineFit::lineal() const {
+    return approx_lineal(polynomialMoments());
+}
+
+Polynomial OnlineFit::polynomial(size_t degree) const {
+    return polynomial_approximation(polynomialMoments(), degree);
+}
+
+std::pair<float, float> OnlineFit::exponential() const {
+    return approx_exponential(linearizedMoments());
+}
+
+std::pair<float, float> OnlineFit::power() const {
+    return approx_power(linearizedMoments());
+}
+
+std::pair<float, float> OnlineFit::log() const {
+    return approx_log(linearizedMoments());
+}
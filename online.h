@@ -0,0 +1,62 @@
+#ifndef FUNCTION_APPROXIMATION_ONLINE_H
+#define FUNCTION_APPROXIMATION_ONLINE_H
+
+#include <vector>
+
+#include "approximation.h"
+#include "moments.h"
+
+/*
+ * Least squares fits of an append-only stream of points.
+ *
+ * Every fit is a function of a fixed set of sums (see Moments and LogMoments), so the fitter keeps
+ * only those sums: add() updates them in O(degree) per point, and the coefficients are solved
+ * from them on demand, without going over the points seen so far.
+ *
+ * The stream has no end, so float running sums would drift without bound (the line of a stream
+ * of y = 2x + 1 is off in the second digit after 10^7 points). The sums are double, as in Moments,
+ * and lose about n * 2^-53 of their value: the line of the same stream is good to 10^-6 after 3 * 10^7 points.
+ */
+class OnlineFit {
+public:
+    /*
+     * degree is the highest polynomial degree that will be asked for, from 1 to 10.
+     * The stream is not known up front, so its x are taken as they are unless a scaling is given:
+     * a stream far from x = 0 fits better around a center and a scale of the x it is expected to have
+     */
+    explicit OnlineFit(size_t degree = 3, const XScaling &scaling = {});
+
+    void add(float x, float y);
+
+    void add(const std::vector<float> &xs, const std::vector<float> &ys);
+
+    size_t size() const {
+        return moments.n;
+    }
+
+    /* the sums of every point added so far */
+    const Moments &polynomialMoments() const {
+        return moments;
+    }
+
+    const LogMoments &linearizedMoments() const {
+        return logMoments;
+    }
+
+    std::pair<float, float> lineal() const;
+
+    /* coefficients b_0, b_1, ..., b_degree of t in the scaling of the fitter */
+    Polynomial polynomial(size_t degree) const;
+
+    std::pair<float, float> exponential() const;
+
+    std::pair<float, float> power() const;
+
+    std::pair<float, float> log() const;
+
+private:
+    Moments moments;
+    LogMoments logMoments;
+};
+
+#endif //FUNCTION_APPROXIMATION_ONLINE_H
@@ -0,0 +1,389 @@
+#include "points_file.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "profile.h"
+#include "thread_pool.h"
+
+namespace {
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + POINTS_FILE_ALIGNMENT - 1) / POINTS_FILE_ALIGNMENT * POINTS_FILE_ALIGNMENT;
+    }
+
+    /*
+     * true if count floats at offset lie past the header and inside the file, at an aligned offset.
+     * The offset is checked against the size first, so nothing from the header is ever added up and wrapped
+     */
+    bool columnFits(uint64_t offset, uint64_t count, uint64_t headerSize, uint64_t fileSize) {
+        return offset % POINTS_FILE_ALIGNMENT == 0 && offset >= headerSize && offset <= fileSize
+               && count <= (fileSize - offset) / sizeof(float);
+    }
+
+    /* lines shorter than this are parsed on the calling thread, a chunk is never smaller than it */
+    const size_t MIN_PARALLEL_BYTES = 1 << 20;
+    const size_t READ_BLOCK_BYTES = 16 << 20;
+
+    /* same set of separators as operator>> skips */
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    std::string readWholeFile(const std::string &fileName) {
+        std::FILE *file = std::fopen(fileName.c_str(), "rb");
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot open the file!");
+        }
+
+        /* blocks are read straight into the text, which grows only if the file is longer than fstat said */
+        std::string text;
+        struct stat info{};
+        if (::fstat(::fileno(file), &info) == 0 && info.st_size > 0) {
+            text.resize(static_cast<size_t>(info.st_size));
+        }
+
+        size_t size = 0;
+        while (true) {
+            size_t read;
+            if (size < text.size()) {
+                read = std::fread(&text[size], 1, std::min(READ_BLOCK_BYTES, text.size() - size), file);
+            } else {
+                /* the text is full: a small read tells the end of the file from more data before the text grows */
+                char probe[4096];
+                read = std::fread(probe, 1, sizeof(probe), file);
+                if (read > 0) {
+                    text.resize(size + READ_BLOCK_BYTES);
+                    std::memcpy(&text[size], probe, read);
+                }
+            }
+
+            if (read == 0) {
+                break;
+            }
+            size += read;
+        }
+
+        std::fclose(file);
+        text.resize(size);
+        return text;
+    }
+
+    size_t countNumbers(const char *begin, const char *end) {
+        size_t count = 0;
+        bool inNumber = false;
+
+        for (const char *p = begin; p != end; p++) {
+            bool space = isSpace(*p);
+            count += !space && !inNumber;
+            inNumber = !space;
+        }
+
+        return count;
+    }
+
+    void parseNumbers(const char *begin, const char *end, float *out) {
+        const char *p = begin;
+
+        while (true) {
+            while (p != end && isSpace(*p)) {
+                p++;
+            }
+            if (p == end) {
+                return;
+            }
+
+            /* from_chars does not accept the leading plus operator>> does */
+            if (*p == '+') {
+                p++;
+            }
+
+            std::from_chars_result parsed = std::from_chars(p, end, *out);
+            if (parsed.ec != std::errc() || (parsed.ptr != end && !isSpace(*parsed.ptr))) {
+                throw std::runtime_error("Cannot parse a number in the points file!");
+            }
+
+            p = parsed.ptr;
+            out++;
+        }
+    }
+
+    /* cuts [begin, end) into about `chunks` pieces, every cut is moved forward to the next whitespace */
+    std::vector<const char *> splitAtSpaces(const char *begin, const char *end, size_t chunks) {
+        std::vector<const char *> bounds = {begin};
+
+        size_t step = static_cast<size_t>(end - begin) / chunks;
+        for (size_t i = 1; i < chunks; i++) {
+            const char *cut = std::max(bounds.back(), begin + i * step);
+            while (cut != end && !isSpace(*cut)) {
+                cut++;
+            }
+            bounds.push_back(cut);
+        }
+
+        bounds.push_back(end);
+        return bounds;
+    }
+
+    std::vector<float> parseLine(const char *begin, const char *end, ThreadPool *pool) {
+        size_t bytes = static_cast<size_t>(end - begin);
+
+        if (pool == nullptr || bytes < MIN_PARALLEL_BYTES) {
+            std::vector<float> numbers(countNumbers(begin, end));
+            parseNumbers(begin, end, numbers.data());
+            return numbers;
+        }
+
+        /* a few chunks per thread keep the threads busy when the numbers are not spread evenly */
+        size_t chunks = std::min(pool->size() * 4, bytes / MIN_PARALLEL_BYTES);
+        std::vector<const char *> bounds = splitAtSpaces(begin, end, chunks);
+
+        std::vector<std::future<size_t>> counted;
+        for (size_t c = 0; c + 1 < bounds.size(); c++) {
+            counted.push_back(pool->submit([&bounds, c]() {
+                return countNumbers(bounds[c], bounds[c + 1]);
+            }));
+        }
+
+        /* offset of the first number of every chunk in the result */
+        std::vector<size_t> offsets(counted.size() + 1, 0);
+        for (size_t c = 0; c < counted.size(); c++) {
+            offsets[c + 1] = offsets[c] + counted[c].get();
+        }
+
+        std::vector<float> numbers(offsets.back());
+
+        std::vector<std::future<void>> parsed;
+        for (size_t c = 0; c + 1 < bounds.size(); c++) {
+            parsed.push_back(pool->submit([&bounds, &numbers, &offsets, c]() {
+                parseNumbers(bounds[c], bounds[c + 1], numbers.data() + offsets[c]);
+            }));
+        }
+
+        /* every chunk has to finish before the buffers go out of scope, even when one of them failed */
+        std::exception_ptr error;
+        for (std::future<void> &chunk : parsed) {
+            try {
+                chunk.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return numbers;
+    }
+}
+
+FunctionPoints readFunctionPointsFromFile(const std::string &fileName, size_t threads) {
+    PROFILE_SCOPE("readFunctionPointsFromFile");
+
+    std::string text = readWholeFile(fileName);
+
+    size_t firstEnd = std::min(text.find('\n'), text.size());
+    size_t secondBegin = std::min(firstEnd + 1, text.size());
+    size_t secondEnd = std::min(text.find('\n', secondBegin), text.size());
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1 && secondEnd > MIN_PARALLEL_BYTES) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+
+    std::vector<float> xs = parseLine(text.data(), text.data() + firstEnd, pool.get());
+    std::vector<float> ys = parseLine(text.data() + secondBegin, text.data() + secondEnd, pool.get());
+
+    return {std::move(xs), std::move(ys)};
+}
+
+std::vector<FunctionPoints> readMultiSeriesFromFile(const std::string &fileName) {
+    PROFILE_SCOPE("readMultiSeriesFromFile");
+
+    std::string text = readWholeFile(fileName);
+    const char *end = text.data() + text.size();
+
+    std::vector<FunctionPoints> series;
+    std::vector<float> xs;
+    bool haveXs = false;
+
+    for (const char *line = text.data(); line < end;) {
+        const char *lineEnd = std::find(line, end, '\n');
+
+        if (countNumbers(line, lineEnd) > 0) {
+            std::vector<float> numbers = parseLine(line, lineEnd, nullptr);
+
+            if (haveXs) {
+                series.emplace_back(std::move(xs), std::move(numbers));
+                xs.clear();
+            } else {
+                xs = std::move(numbers);
+            }
+            haveXs = !haveXs;
+        }
+
+        line = lineEnd + 1;
+    }
+
+    if (haveXs) {
+        throw std::runtime_error("The last series has no line of ys!");
+    }
+
+    return series;
+}
+
+FunctionPoints loadFunctionPoints(const std::string &fileName) {
+    PROFILE_SCOPE("loadFunctionPoints");
+
+    if (!isBinaryPointsFile(fileName)) {
+        return readFunctionPointsFromFile(fileName);
+    }
+
+    MappedPoints mapped(fileName);
+    return {
+            std::vector<float>(mapped.xs(), mapped.xs() + mapped.size()),
+            std::vector<float>(mapped.ys(), mapped.ys() + mapped.size())
+    };
+}
+
+bool isBinaryPointsFile(const std::string &fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+
+    char magic[sizeof(POINTS_FILE_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+
+    return file && std::memcmp(magic, POINTS_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+void writeBinaryPoints(const std::string &fileName, const std::vector<float> &xs, const std::vector<float> &ys) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
+
+    PointsFileHeader header{};
+    std::memcpy(header.magic, POINTS_FILE_MAGIC, sizeof(header.magic));
+    header.version = POINTS_FILE_VERSION;
+    header.dtype = static_cast<uint32_t>(PointsDtype::Float32);
+    header.headerSize = static_cast<uint32_t>(alignUp(sizeof(PointsFileHeader)));
+    header.count = xs.size();
+    header.xOffset = header.headerSize;
+    header.yOffset = alignUp(header.xOffset + header.count * sizeof(float));
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open the file for writing!");
+    }
+
+    const std::vector<char> padding(POINTS_FILE_ALIGNMENT, 0);
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(padding.data(), static_cast<std::streamsize>(header.xOffset - sizeof(header)));
+    file.write(reinterpret_cast<const char *>(xs.data()), static_cast<std::streamsize>(xs.size() * sizeof(float)));
+    file.write(padding.data(), static_cast<std::streamsize>(header.yOffset - header.xOffset - xs.size() * sizeof(float)));
+    file.write(reinterpret_cast<const char *>(ys.data()), static_cast<std::streamsize>(ys.size() * sizeof(float)));
+
+    if (!file) {
+        throw std::runtime_error("Cannot write the points file!");
+    }
+}
+
+void convertTextToBinary(const std::string &textFileName, const std::string &binaryFileName) {
+    FunctionPoints points = readFunctionPointsFromFile(textFileName);
+    writeBinaryPoints(binaryFileName, points.first, points.second);
+}
+
+MappedPoints::MappedPoints(const std::string &fileName) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open the file!");
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(PointsFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("The points file is too short!");
+    }
+
+    mappingSize = static_cast<size_t>(info.st_size);
+    mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Cannot map the points file!");
+    }
+
+    /* the columns are read front to back by every fit */
+    ::madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    PointsFileHeader header{};
+    std::memcpy(&header, mapping, sizeof(header));
+
+    const char *error = nullptr;
+    if (std::memcmp(header.magic, POINTS_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        error = "Not a binary points file!";
+    } else if (header.version != POINTS_FILE_VERSION) {
+        error = "Unsupported points file version!";
+    } else if (header.dtype != static_cast<uint32_t>(PointsDtype::Float32)) {
+        error = "Unsupported points data type!";
+    } else if (header.headerSize < sizeof(PointsFileHeader) || header.headerSize > mappingSize
+               || !columnFits(header.xOffset, header.count, header.headerSize, mappingSize)
+               || !columnFits(header.yOffset, header.count, header.headerSize, mappingSize)) {
+        error = "The points file is truncated or corrupted!";
+    }
+
+    if (error != nullptr) {
+        ::munmap(mapping, mappingSize);
+        mapping = nullptr;
+        throw std::runtime_error(error);
+    }
+
+    const char *base = static_cast<const char *>(mapping);
+    x = reinterpret_cast<const float *>(base + header.xOffset);
+    y = reinterpret_cast<const float *>(base + header.yOffset);
+    count = header.count;
+}
+
+MappedPoints::~MappedPoints() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mappingSize);
+    }
+}
+
+MappedPoints::MappedPoints(MappedPoints &&other) noexcept
+        : mapping(std::exchange(other.mapping, nullptr)), mappingSize(std::exchange(other.mappingSize, 0)),
+          x(std::exchange(other.x, nullptr)), y(std::exchange(other.y, nullptr)), count(std::exchange(other.count, 0)) {}
+
+MappedPoints &MappedPoints::operator=(MappedPoints &&other) noexcept {
+    if (this != &other) {
+        if (mapping != nullptr) {
+            ::munmap(mapping, mappingSize);
+        }
+
+        mapping = std::exchange(other.mapping, nullptr);
+        mappingSize = std::exchange(other.mappingSize, 0);
+        x = std::exchange(other.x, nullptr);
+        y = std::exchange(other.y, nullptr);
+        count = std::exchange(other.count, 0);
+    }
+
+    return *this;
+}
@@ -0,0 +1,99 @@
+#ifndef FUNCTION_APPROXIMATION_POINTS_FILE_H
+#define FUNCTION_APPROXIMATION_POINTS_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef std::pair<std::vector<float>, std::vector<float>> FunctionPoints;
+
+/*
+ * text format: the first line holds the xs, the second line the ys, separated by whitespace
+ *
+ * The file is read in large blocks, each line is cut into chunks at whitespace boundaries,
+ * and the chunks are parsed with std::from_chars on several threads (threads = 0 picks one per core)
+ * straight into vectors sized beforehand by counting the numbers of every chunk.
+ */
+FunctionPoints readFunctionPointsFromFile(const std::string &fileName, size_t threads = 0);
+
+/*
+ * Binary columnar format, version 1, little-endian:
+ *
+ * offset 0   PointsFileHeader (padded to 64 bytes)
+ * xOffset    count values of x
+ * yOffset    count values of y
+ *
+ * Both columns start at a 64 byte boundary, so once the file is mapped they can be handed
+ * to the fitting routines and vector kernels as plain arrays, without parsing or copying.
+ */
+const char POINTS_FILE_MAGIC[4] = {'F', 'A', 'P', 'T'};
+const uint32_t POINTS_FILE_VERSION = 1;
+const size_t POINTS_FILE_ALIGNMENT = 64;
+
+enum class PointsDtype : uint32_t {
+    Float32 = 1
+};
+
+struct PointsFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t dtype;
+    uint32_t headerSize;
+    uint64_t count;
+    uint64_t xOffset;
+    uint64_t yOffset;
+};
+
+/* several series in the text format, one pair of lines (xs, then ys) per series; empty lines are skipped */
+std::vector<FunctionPoints> readMultiSeriesFromFile(const std::string &fileName);
+
+/* reads the binary format if the file starts with its magic, the text format otherwise */
+FunctionPoints loadFunctionPoints(const std::string &fileName);
+
+/* true if the file starts with the binary format magic */
+bool isBinaryPointsFile(const std::string &fileName);
+
+void writeBinaryPoints(const std::string &fileName, const std::vector<float> &xs, const std::vector<float> &ys);
+
+/* reads the text format and writes the same points in the binary format */
+void convertTextToBinary(const std::string &textFileName, const std::string &binaryFileName);
+
+/*
+ * read-only memory mapping of a binary points file;
+ * xs() and ys() point straight into the mapping and stay valid while the object lives
+ */
+class MappedPoints {
+public:
+    explicit MappedPoints(const std::string &fileName);
+
+    ~MappedPoints();
+
+    MappedPoints(const MappedPoints &) = delete;
+    MappedPoints &operator=(const MappedPoints &) = delete;
+
+    MappedPoints(MappedPoints &&other) noexcept;
+    MappedPoints &operator=(MappedPoints &&other) noexcept;
+
+    const float *xs() const {
+        return x;
+    }
+
+    const float *ys() const {
+        return y;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+private:
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+
+    const float *x = nullptr;
+    const float *y = nullptr;
+    size_t count = 0;
+};
+
+#endif //FUNCTION_APPROXIMATION_POINTS_FILE_H
@@ -0,0 +1,34 @@
+#include "polyfit.h"
+
+namespace {
+    template<size_t Degree, typename... Source>
+    Polynomial fit_degree(const Source &... source) {
+        return PolyFit<Degree>::polynomial(source...);
+    }
+
+    template<typename... Source>
+    Polynomial dispatch(size_t degree, const Source &... source) {
+        switch (degree) {
+            case 1: return fit_degree<1>(source...);
+            case 2: return fit_degree<2>(source...);
+            case 3: return fit_degree<3>(source...);
+            case 4: return fit_degree<4>(source...);
+            case 5: return fit_degree<5>(source...);
+            case 6: return fit_degree<6>(source...);
+            case 7: return fit_degree<7>(source...);
+            case 8: return fit_degree<8>(source...);
+            case 9: return fit_degree<9>(source...);
+            case 10: return fit_degree<10>(source...);
+            default:
+                throw std::runtime_error("Polynomial degree must be from 1 to 10!");
+        }
+    }
+}
+
+Polynomial polynomial_approximation(const std::vector<float> &xs, const std::vector<float> &ys, size_t degree) {
+    return dispatch(degree, xs, ys);
+}
+
+Polynomial polynomial_approximation(const Moments &m, size_t degree) {
+    return dispatch(degree, m);
+}
@@ -0,0 +1,234 @@
+#ifndef FUNCTION_APPROXIMATION_POLYFIT_H
+#define FUNCTION_APPROXIMATION_POLYFIT_H
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#include "/home/cleanyco/Downloads/eigen-3.4.0/Eigen/Core"
+#include "/home/cleanyco/Downloads/eigen-3.4.0/Eigen/Dense"
+
+#include "moments.h"
+#include "polynomial.h"
+#include "profile.h"
+
+/*
+ * Least squares polynomial of a fixed degree: φ(x) = a_0 + a_1*x + ... + a_m*x^m
+ *
+ * S(a_0, ..., a_m) = Σ[1, n](φ(x_i) - y_i)^2 -> min
+ * dS/da_j = 0 gives the normal system A * a = B with
+ *
+ * A[j][k] = Σx^(j + k), B[j] = Σx^j * y, j, k = 0 .. m
+ *
+ * Degree is known at compile time, so the matrix, the power sums and the per point kernel are all
+ * fixed size: nothing is allocated on the heap and the kernel is unrolled by the compiler.
+ *
+ * The system is the same for t = (x - center) / scale (see XScaling) with the power sums of t, and that is
+ * how polynomial() solves it: the Gram matrix of 1, x, ..., x^m on x in [100, 110] is too close to singular
+ * for try_solve from degree 2 on, the one of 1, t, ..., t^m on [-1, 1] is not.
+ */
+template<size_t Degree>
+class PolyFit {
+    static_assert(Degree >= 1 && Degree <= 10, "PolyFit supports degrees from 1 to 10");
+
+public:
+    static constexpr int Size = Degree + 1;
+
+    typedef Eigen::Matrix<float, Size, Size> Matrix;
+    typedef Eigen::Matrix<float, Size, 1> Vector;
+
+    /* in double, like Moments */
+    struct PowerSums {
+        size_t n = 0;
+        std::array<double, 2 * Degree + 1> sx{};  /* Σx^k,   k = 0 .. 2 * Degree */
+        std::array<double, Degree + 1> sxy{};     /* Σx^k*y, k = 0 .. Degree */
+    };
+
+    static PowerSums power_sums(const std::vector<float> &xs, const std::vector<float> &ys) {
+        if (xs.size() != ys.size()) {
+            throw std::runtime_error("The number of points x and y don't match!");
+        }
+
+        return power_sums(xs.data(), ys.data(), xs.size());
+    }
+
+    /* power sums of t = (x - center) / scale, of x itself with the default scaling */
+    static PowerSums power_sums(const float *xs, const float *ys, size_t n, const XScaling &scaling = {}) {
+        PROFILE_SCOPE("PolyFit::power_sums");
+        PROFILE_COUNT("points", n);
+
+        PowerSums s;
+        s.n = n;
+
+        const float center = static_cast<float>(scaling.center);
+        const float inverse = scaling.inverse();
+
+        for (size_t i = 0; i < n; i++) {
+            accumulate((xs[i] - center) * inverse, ys[i], s, std::make_index_sequence<2 * Degree + 1>{});
+        }
+
+        return s;
+    }
+
+    /* takes the power sums from moments computed for Degree or higher */
+    static PowerSums power_sums(const Moments &m) {
+        if (m.degree < Degree) {
+            throw std::runtime_error("Moments degree is lower than the degree of the polynomial!");
+        }
+
+        PowerSums s;
+        s.n = m.n;
+        for (size_t k = 0; k <= 2 * Degree; k++) {
+            s.sx[k] = m.sx[k];
+        }
+        for (size_t k = 0; k <= Degree; k++) {
+            s.sxy[k] = m.sxy[k];
+        }
+
+        return s;
+    }
+
+    /*
+     * A is the Gram matrix of 1, x, ..., x^m, symmetric positive definite whenever the fit is unique,
+     * so it is factored by LDLT (in double, it is at most 11 x 11). Instead of det(A) == 0, which rounding
+     * almost never hits exactly, the estimated reciprocal condition number of the equilibrated matrix has to
+     * be at least the float epsilon: below that, a change of A at the rounding level of its float sums can
+     * make it singular.
+     */
+    static Vector solve(const PowerSums &s) {
+        PROFILE_SCOPE("PolyFit::solve");
+        PROFILE_COUNT("solver_calls", 1);
+
+        Vector a;
+        if (!try_solve(s, a)) {
+            throw std::runtime_error("The system of equations has no unique solution!");
+        }
+
+        return a;
+    }
+
+    /* solve without the exception: false if the system has no reliable unique solution */
+    static bool try_solve(const PowerSums &s, Vector &a) {
+        Eigen::Matrix<double, Size, Size> A;
+        Eigen::Matrix<double, Size, 1> B;
+
+        for (int j = 0; j < Size; j++) {
+            for (int k = 0; k < Size; k++) {
+                A(j, k) = s.sx[j + k];
+            }
+            B(j) = s.sxy[j];
+        }
+
+        /* Σx^0 is the number of points */
+        A(0, 0) = static_cast<double>(s.n);
+
+        /*
+         * The powers of x differ in magnitude by orders, so the system is equilibrated first:
+         * D * A * D * (D^-1 * a) = D * B with D = diag(1 / sqrt(A[j][j])). This leaves the solution alone
+         * and makes rcond measure how close the basis is to degenerate, not how large x is.
+         */
+        Eigen::Matrix<double, Size, 1> D;
+        for (int j = 0; j < Size; j++) {
+            if (!(A(j, j) > 0)) {
+                return false;
+            }
+            D(j) = 1 / std::sqrt(A(j, j));
+        }
+        A = D.asDiagonal() * A * D.asDiagonal();
+
+        /*
+         * LDLT solves around a pivot that is exactly 0 instead of failing, and rcond is estimated through
+         * that solve, so it misses such a pivot (x all equal, say): the pivots are checked against each other
+         * as well. For a symmetric positive definite matrix their ratio never falls below rcond.
+         */
+        Eigen::LDLT<Eigen::Matrix<double, Size, Size>> ldlt(A);
+        if (ldlt.info() != Eigen::Success || !ldlt.isPositive()) {
+            return false;
+        }
+
+        const double epsilon = std::numeric_limits<float>::epsilon();
+        const auto &pivots = ldlt.vectorD();
+        if (!(pivots.minCoeff() >= epsilon * pivots.maxCoeff()) || !(ldlt.rcond() >= epsilon)) {
+            return false;
+        }
+
+        a = D.cwiseProduct(ldlt.solve(D.cwiseProduct(B))).template cast<float>();
+        return a.allFinite();
+    }
+
+    /*
+     * solves many small systems in one call (the batch driver fits thousands of series):
+     * no exceptions and no allocations, solved[i] tells whether out[i] holds a solution
+     */
+    static void solve_all(const PowerSums *sums, size_t count, Vector *out, bool *solved) {
+        PROFILE_SCOPE("PolyFit::solve_all");
+        PROFILE_COUNT("solver_calls", count);
+
+        for (size_t i = 0; i < count; i++) {
+            solved[i] = try_solve(sums[i], out[i]);
+        }
+    }
+
+    static Vector fit(const std::vector<float> &xs, const std::vector<float> &ys) {
+        return solve(power_sums(xs, ys));
+    }
+
+    static Vector fit(const float *xs, const float *ys, size_t n) {
+        return solve(power_sums(xs, ys, n));
+    }
+
+    static Vector fit(const Moments &m) {
+        return solve(power_sums(m));
+    }
+
+    /* fits in t = (x - center) / scale, the coefficients are those of t */
+    static Vector fit(const float *xs, const float *ys, size_t n, const XScaling &scaling) {
+        return solve(power_sums(xs, ys, n, scaling));
+    }
+
+    /* the fit in t of centered_scaling(xs), with the scaling it is in */
+    static Polynomial polynomial(const float *xs, const float *ys, size_t n) {
+        XScaling scaling = centered_scaling(xs, n);
+        return {coefficients(fit(xs, ys, n, scaling)), scaling};
+    }
+
+    static Polynomial polynomial(const std::vector<float> &xs, const std::vector<float> &ys) {
+        if (xs.size() != ys.size()) {
+            throw std::runtime_error("The number of points x and y don't match!");
+        }
+
+        return polynomial(xs.data(), ys.data(), xs.size());
+    }
+
+    /* the fit in t of the scaling the moments were summed in */
+    static Polynomial polynomial(const Moments &m) {
+        return {coefficients(fit(m)), m.scaling};
+    }
+
+    /* coefficients in the order a_0, a_1, ..., a_m */
+    static std::vector<float> coefficients(const Vector &a) {
+        return std::vector<float>(a.data(), a.data() + Size);
+    }
+
+private:
+    /* x^0 .. x^(2 * Degree) are built by a fold over the index pack, so the loop is unrolled at compile time */
+    template<size_t... K>
+    static void accumulate(double x, double y, PowerSums &s, std::index_sequence<K...>) {
+        std::array<double, 2 * Degree + 1> p{};
+        p[0] = 1.0;
+        ((K > 0 ? (p[K] = p[K - 1] * x) : p[0]), ...);
+
+        ((s.sx[K] += p[K]), ...);
+        ((K <= Degree ? (s.sxy[K] += p[K] * y) : 0.0), ...);
+    }
+};
+
+/* runtime dispatch to PolyFit<degree>::polynomial, degree from 1 to 10; the coefficients are those of t */
+Polynomial polynomial_approximation(const std::vector<float> &xs, const std::vector<float> &ys, size_t degree);
+
+Polynomial polynomial_approximation(const Moments &m, size_t degree);
+
+#endif //FUNCTION_APPROXIMATION_POLYFIT_H
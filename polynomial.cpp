@@ -0,0 +1,86 @@
+#include "polynomial.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd.h"
+
+XScaling centered_scaling(const float *xs, size_t n) {
+    using namespace simd;
+
+    XScaling scaling;
+    if (n == 0) {
+        return scaling;
+    }
+
+    float low = xs[0];
+    float high = xs[0];
+
+    size_t i = 0;
+    if (n >= WIDTH) {
+        Vec lows = load(xs);
+        Vec highs = lows;
+        for (; i + WIDTH <= n; i += WIDTH) {
+            Vec x = load(xs + i);
+            lows = min(lows, x);
+            highs = max(highs, x);
+        }
+
+        float lanes[WIDTH];
+        store(lanes, lows);
+        low = *std::min_element(lanes, lanes + WIDTH);
+        store(lanes, highs);
+        high = *std::max_element(lanes, lanes + WIDTH);
+    }
+    for (; i < n; i++) {
+        low = std::min(low, xs[i]);
+        high = std::max(high, xs[i]);
+    }
+
+    if (!std::isfinite(low) || !std::isfinite(high)) {
+        return scaling;
+    }
+
+    /* x - center is one rounding in float, the scale a power of two adds none */
+    scaling.center = static_cast<float>((static_cast<double>(low) + high) / 2);
+
+    double spread = std::max(high - scaling.center, scaling.center - low);
+    if (spread > 0) {
+        scaling.scale = std::exp2(std::ceil(std::log2(spread)));
+    }
+
+    return scaling;
+}
+
+float evaluate(const Polynomial &p, float x) {
+    const std::vector<float> &b = p.coefficients;
+    float t = p.scaling.t(x);
+
+    float value = b.back();
+    for (size_t k = b.size() - 1; k-- > 0;) {
+        value = std::fma(value, t, b[k]);
+    }
+    return value;
+}
+
+std::vector<float> expanded(const Polynomial &p) {
+    const std::vector<float> &b = p.coefficients;
+    const double shift = -p.scaling.center / p.scaling.scale;
+
+    std::vector<float> a(b.size());
+    double inversePower = 1;   /* s^(-j) */
+    for (size_t j = 0; j < b.size(); j++) {
+        double sum = 0;
+        double binomial = 1;   /* C(k, j) */
+        double shiftPower = 1; /* (-c / s)^(k - j) */
+        for (size_t k = j; k < b.size(); k++) {
+            sum += b[k] * binomial * shiftPower;
+            binomial = binomial * static_cast<double>(k + 1) / static_cast<double>(k + 1 - j);
+            shiftPower *= shift;
+        }
+        a[j] = static_cast<float>(sum * inversePower);
+        inversePower /= p.scaling.scale;
+    }
+
+    return a;
+}
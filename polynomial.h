@@ -0,0 +1,64 @@
+#ifndef FUNCTION_APPROXIMATION_POLYNOMIAL_H
+#define FUNCTION_APPROXIMATION_POLYNOMIAL_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Substitution t = (x - center) / scale for the polynomial fits. With x far from zero (x ~ 1000, degree 3)
+ * Σx^6 and n are 18 orders of magnitude apart and the normal system is hopeless even in double;
+ * centered and scaled into [-1, 1] the power sums of t stay comparable to n.
+ * The default is the identity, t is then x itself.
+ *
+ * t is taken in float wherever it is needed (the sums, the scoring, evaluate), always as
+ * (x - center) * (1 / scale): the center is a float and the scale a power of two, so every place gets
+ * the same t for the same x. Only x - center rounds, the scaled fit is a better conditioned fit of the same data,
+ * not a bit-identical one.
+ */
+struct XScaling {
+    double center = 0;
+    double scale = 1;
+
+    float inverse() const {
+        return static_cast<float>(1 / scale);
+    }
+
+    float t(float x) const {
+        return (x - static_cast<float>(center)) * inverse();
+    }
+};
+
+/*
+ * the middle of the range of x as a float for the center, the power of two just above the half-width
+ * for the scale, so t fills [-1, 1]; the identity if x is empty, constant or not finite. One vectorized pass
+ */
+XScaling centered_scaling(const float *xs, size_t n);
+
+/*
+ * φ(x) = b_0 + b_1 * t + ... + b_m * t^m, t = (x - center) / scale: a polynomial fit as it was solved.
+ *
+ * The coefficients stay those of t. Expanded into the powers of x they cancel each other as soon as
+ * the center is large against the scale, and the float a_k of x no longer reproduce the fit
+ * (degree 5 on x in [100, 110] misses by orders of magnitude more than the noise), so φ is evaluated in t
+ * and the expansion is only for showing the fit to a person.
+ */
+struct Polynomial {
+    std::vector<float> coefficients;
+    XScaling scaling;
+
+    size_t degree() const {
+        return coefficients.size() - 1;
+    }
+};
+
+/* φ(x) by Horner's scheme in t */
+float evaluate(const Polynomial &p, float x);
+
+/*
+ * a_0, a_1, ..., a_m of x, Σ b_k t^k expanded by the binomial theorem in double:
+ *
+ * a_j = Σ[k = j, m] b_k * C(k, j) * s^(-j) * (-c / s)^(k - j)
+ */
+std::vector<float> expanded(const Polynomial &p);
+
+#endif //FUNCTION_APPROXIMATION_POLYNOMIAL_H
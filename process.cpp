@@ -1,290 +1,535 @@
 #include "process.h"
 
-float process_lineal(Points &xs, Points &ys) {
-    std::cout << "<lineal approximation>" << std::endl;
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <sstream>
+
+#include "cross_validation.h"
+#include "diagnostics.h"
+#include "refine.h"
+#include "scoring.h"
+#include "thread_pool.h"
+
+namespace {
+    /* φ(x_i) is evaluated while the row is formatted, nothing per point is kept in memory */
+    template<typename Phi>
+    void printApproximationTable(const std::string &eq, const Points &xs, const Points &ys, Phi phi_of_x,
+                                 std::ostream &out, size_t tableRows) {
+        /* a limit keeps the first and the last half of it */
+        TableWriter table({{"i", 0}, {"x"}, {"y"}, {eq}, {"epsilon"}}, tableRows - tableRows / 2, tableRows / 2);
+
+        table.write(xs.size(), [&](size_t i, double *row) {
+            float phi = phi_of_x(xs[i]);
+
+            row[0] = static_cast<double>(i + 1);
+            row[1] = xs[i];
+            row[2] = ys[i];
+            row[3] = phi;
+            row[4] = std::abs(phi - ys[i]);
+        }, out);
+    }
 
-    Coefficients cf = approx_lineal(xs, ys);
-    float a = cf.first;
-    float b = cf.second;
+    /*
+     * float keeps 9 significant digits. nan, inf and -inf (a failed fit, an overflowed sum) are not numbers
+     * in JSON and are written as null there, and as nan in CSV, the same as the batch records
+     */
+    void writeNumber(std::ostream &out, float value, OutputFormat format) {
+        if (!std::isfinite(value)) {
+            out << (format == OutputFormat::Json ? "null" : "nan");
+            return;
+        }
+
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        out << buffer;
+    }
 
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * x + b;
-    };
+    /* R², adjusted R², AIC and BIC after the other numbers of a fit, CSV columns or JSON members */
+    void writeDiagnostics(std::ostream &out, const Diagnostics &d, OutputFormat format) {
+        const char *names[] = {"r2", "adj_r2", "aic", "bic"};
+        const float values[] = {d.rSquared, d.adjustedRSquared, d.aic, d.bic};
+
+        for (size_t i = 0; i < std::size(values); i++) {
+            if (format == OutputFormat::Json) {
+                out << ", \"" << names[i] << "\": ";
+            } else {
+                out << ',';
+            }
+            writeNumber(out, values[i], format);
+        }
+    }
 
-    std::vector<float> phi;
-    for (float x : xs) {
-        phi.push_back(phi_of_x(x));
+    /* a model whose fit fails is kept with no coefficients, score_fits gives it nan deviations */
+    FitResult quietFit(Model model, const float *xs, const float *ys, size_t n, const Moments &moments,
+                       const LogColumns &logs, bool refine) {
+        try {
+            return fit_coefficients(model, xs, ys, n, moments, logs, refine);
+        } catch (const std::exception &) {
+            return {model, {}};
+        }
     }
 
-    std::string eq = std::to_string(a) + "x + " + std::to_string(b);
-    const std::vector<std::string> HEADERS = {"i", "x", "y", eq, "epsilon"};
-    std::vector<std::vector<std::string>> LINES;
+    /* the report* functions print a fit that is already scored, they never go over the points for S again */
+    void reportLineal(const FitResult &fit, const Points &xs, const Points &ys, const Moments &moments,
+                      std::ostream &out, size_t tableRows) {
+        out << "<lineal approximation>" << std::endl;
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        std::vector<std::string> LINE;
+        float a = fit.coefficients[0];
+        float b = fit.coefficients[1];
 
-        LINE.push_back(std::to_string(i + 1));
-        LINE.push_back(std::to_string(xs[i]));
-        LINE.push_back(std::to_string(ys[i]));
-        LINE.push_back(std::to_string(phi[i]));
-        LINE.push_back(std::to_string(std::abs(phi[i] - ys[i])));
-        LINES.push_back(LINE);
-    }
+        auto phi_of_x = [a, b](float x) -> float {
+            return a * x + b;
+        };
 
-    std::cout << "<TABLE>" << std::endl;
-    printTable(HEADERS, LINES);
+        std::string eq = std::to_string(a) + "x + " + std::to_string(b);
 
-    std::cout << "We got a = " << a << " and b = " << b << std::endl;
+        out << "<TABLE>" << std::endl;
+        printApproximationTable(eq, xs, ys, phi_of_x, out, tableRows);
 
-    float linealDeviation = deviation_lineal(a, b, xs, ys);
-    std::cout << "Deviation measure for linear approximation = " << linealDeviation << std::endl;
+        out << "We got a = " << a << " and b = " << b << std::endl;
+        out << "Deviation measure for linear approximation = " << fit.deviation << std::endl;
+        out << "Standard deviation for lineal approximation (δ)= " << fit.standardDeviation << std::endl;
 
-    size_t n = xs.size();
-    float linealStandardDeviation = standard_deviation(linealDeviation, n);
-    std::cout << "Standard deviation for lineal approximation (δ)= " << linealStandardDeviation << std::endl;
+        /* r comes from the moments the fit was made of, not from another pass over the points */
+        float pearsonCoefficient = correlation_coefficient(moments);
+        out << "Pearson coefficient for linear approximation (r) = " << pearsonCoefficient << std::endl;
 
-    float pearsonCoefficient = correlation_coefficient(xs, ys);
-    std::cout << "Pearson coefficient for linear approximation (r) = " << pearsonCoefficient << std::endl;
+        out << "<lineal approximation> [END]" << std::endl;
+    }
 
-    std::cout << "<lineal approximation> [END]" << std::endl;
+    void reportQuadratic(const FitResult &fit, const Points &xs, const Points &ys, std::ostream &out,
+                         size_t tableRows) {
+        out << "<quadratic approximation>" << std::endl;
 
-    return linealStandardDeviation;
-}
+        /* φ is evaluated in t, the coefficients of x are only shown */
+        std::vector<float> a = reportedCoefficients(fit);
+        float a_0 = a[0];
+        float a_1 = a[1];
+        float a_2 = a[2];
 
-float process_quadratic(Points &xs, Points &ys) {
-    std::cout << "<quadratic approximation>" << std::endl;
+        auto phi_of_x = [&fit](float x) -> float {
+            return evaluate(fit, x);
+        };
 
-    std::vector<float> cf = quadratic_approximation(xs, ys);
-    float a_0 = cf[0];
-    float a_1 = cf[1];
-    float a_2 = cf[2];
+        std::string eq = std::to_string(a_0) + std::to_string(a_1) + "x + " + std::to_string(a_2) + "x^2";
 
-    auto phi_of_x = [a_0, a_1, a_2](float x) -> float {
-        return a_2 * std::pow(x, 2) + a_1 * std::pow(x, 1) + a_0 * std::pow(x, 0);
-    };
+        out << "<TABLE>" << std::endl;
+        printApproximationTable(eq, xs, ys, phi_of_x, out, tableRows);
 
-    std::vector<float> phi;
-    for (float x : xs) {
-        phi.push_back(phi_of_x(x));
+        out << "We got a_0 = " << a_0 << " and a_1 = " << a_1 << " and a_2 = " << a_2 << std::endl;
+        out << "Deviation measure for quadratic approximation = " << fit.deviation << std::endl;
+        out << "Standard deviation for quadratic approximation (δ)= " << fit.standardDeviation << std::endl;
+
+        out << "<quadratic approximation> [END]" << std::endl;
     }
 
-    std::string eq = std::to_string(a_0) + std::to_string(a_1) + "x + " + std::to_string(a_2) + "x^2";
-    const std::vector<std::string> HEADERS = {"i", "x", "y", eq, "epsilon"};
-    std::vector<std::vector<std::string>> LINES;
+    void reportQube(const FitResult &fit, const Points &xs, const Points &ys, std::ostream &out, size_t tableRows) {
+        out << "<qube approximation>" << std::endl;
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        std::vector<std::string> LINE;
+        std::vector<float> a = reportedCoefficients(fit);
+        float a_0 = a[0];
+        float a_1 = a[1];
+        float a_2 = a[2];
+        float a_3 = a[3];
 
-        LINE.push_back(std::to_string(i + 1));
-        LINE.push_back(std::to_string(xs[i]));
-        LINE.push_back(std::to_string(ys[i]));
-        LINE.push_back(std::to_string(phi[i]));
-        LINE.push_back(std::to_string(std::abs(phi[i] - ys[i])));
-        LINES.push_back(LINE);
-    }
+        auto phi_of_x = [&fit](float x) -> float {
+            return evaluate(fit, x);
+        };
 
-    std::cout << "<TABLE>" << std::endl;
-    printTable(HEADERS, LINES);
+        std::string eq = std::to_string(a_0) + std::to_string(a_1) + "x + " + std::to_string(a_2) + "x^2"
+                + std::to_string(a_3) + "x^3";
 
-    std::cout << "We got a_0 = " << a_0 << " and a_1 = " << a_1 << " and a_2 = " << a_2 << std::endl;
+        out << "<TABLE>" << std::endl;
+        printApproximationTable(eq, xs, ys, phi_of_x, out, tableRows);
 
-    float quadraticDeviation = deviation_quadratic(a_0, a_1, a_2 ,xs, ys);
-    std::cout << "Deviation measure for quadratic approximation = " << quadraticDeviation << std::endl;
+        out << "We got a_0 = " << a_0 << " and a_1 = " << a_1 << " and a_2 = " << a_2 << " and a_3 = " << a_3 <<std::endl;
+        out << "Deviation measure for cube approximation = " << fit.deviation << std::endl;
+        out << "Standard deviation for cube approximation (δ)= " << fit.standardDeviation << std::endl;
 
-    size_t n = xs.size();
-    float quadraticStandardDeviation = standard_deviation(quadraticDeviation, n);
-    std::cout << "Standard deviation for quadratic approximation (δ)= " << quadraticStandardDeviation << std::endl;
+        out << "<cube approximation> [END]" << std::endl;
+    }
 
-    std::cout << "<quadratic approximation> [END]" << std::endl;
+    void reportPower(const FitResult &fit, const Points &xs, const Points &ys, std::ostream &out, size_t tableRows) {
+        out << "<power approximation>" << std::endl;
 
-    return quadraticStandardDeviation;
-}
+        float a = fit.coefficients[0];
+        float b = fit.coefficients[1];
 
-float process_qube(Points &xs, Points &ys) {
-    std::cout << "<qube approximation>" << std::endl;
+        auto phi_of_x = [a, b](float x) -> float {
+            return a * std::pow(x, b);
+        };
 
-    std::vector<float> cf = cube_approximation(xs, ys);
-    float a_0 = cf[0];
-    float a_1 = cf[1];
-    float a_2 = cf[2];
-    float a_3 = cf[3];
+        std::string eq = std::to_string(a) + "x^" + std::to_string(b);
 
-    auto phi_of_x = [a_0, a_1, a_2, a_3](float x) -> float {
-        return a_3 * std::pow(x, 3) + a_2 * std::pow(x, 2) + a_1 * std::pow(x, 1) + a_0 * std::pow(x, 0);
-    };
+        out << "<TABLE>" << std::endl;
+        printApproximationTable(eq, xs, ys, phi_of_x, out, tableRows);
 
-    std::vector<float> phi;
-    for (float x : xs) {
-        phi.push_back(phi_of_x(x));
+        out << "We got a = " << a << " and b = " << b << std::endl;
+        out << "Deviation measure for power approximation = " << fit.deviation << std::endl;
+        out << "Standard deviation for power approximation (δ)= " << fit.standardDeviation << std::endl;
     }
 
-    std::string eq = std::to_string(a_0) + std::to_string(a_1) + "x + " + std::to_string(a_2) + "x^2"
-            + std::to_string(a_3) + "x^3";
-    const std::vector<std::string> HEADERS = {"i", "x", "y", eq, "epsilon"};
-    std::vector<std::vector<std::string>> LINES;
+    void reportExp(const FitResult &fit, const Points &xs, const Points &ys, std::ostream &out, size_t tableRows) {
+        out << "<exp approximation>" << std::endl;
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        std::vector<std::string> LINE;
+        float a = fit.coefficients[0];
+        float b = fit.coefficients[1];
 
-        LINE.push_back(std::to_string(i + 1));
-        LINE.push_back(std::to_string(xs[i]));
-        LINE.push_back(std::to_string(ys[i]));
-        LINE.push_back(std::to_string(phi[i]));
-        LINE.push_back(std::to_string(std::abs(phi[i] - ys[i])));
-        LINES.push_back(LINE);
-    }
+        auto phi_of_x = [a, b](float x) -> float {
+            return a * std::exp(b * x);
+        };
 
-    std::cout << "<TABLE>" << std::endl;
-    printTable(HEADERS, LINES);
+        std::string eq = std::to_string(a) + "e^("  + std::to_string(b) + "x)";
 
-    std::cout << "We got a_0 = " << a_0 << " and a_1 = " << a_1 << " and a_2 = " << a_2 << " and a_3 = " << a_3 <<std::endl;
+        out << "<TABLE>" << std::endl;
+        printApproximationTable(eq, xs, ys, phi_of_x, out, tableRows);
 
-    float cubeDeviation = deviation_qube(a_0, a_1, a_2, a_3, xs, ys);
-    std::cout << "Deviation measure for cube approximation = " << cubeDeviation << std::endl;
+        out << "We got a = " << a << " and b = " << b << std::endl;
+        out << "Deviation measure for exponential approximation = " << fit.deviation << std::endl;
+        out << "Standard deviation for exponential approximation (δ)= " << fit.standardDeviation << std::endl;
+    }
 
-    size_t n = xs.size();
-    float cubeStandardDeviation = standard_deviation(cubeDeviation, n);
-    std::cout << "Standard deviation for cube approximation (δ)= " << cubeStandardDeviation << std::endl;
+    void reportLog(const FitResult &fit, const Points &xs, const Points &ys, std::ostream &out, size_t tableRows) {
+        out << "<log approximation>" << std::endl;
 
-    std::cout << "<cube approximation> [END]" << std::endl;
+        float a = fit.coefficients[0];
+        float b = fit.coefficients[1];
 
-    return cubeStandardDeviation;
-}
+        auto phi_of_x = [a, b](float x) -> float {
+            return a * std::log(x) + b;
+        };
 
-float process_power(Points &xs, Points &ys) {
-    std::cout << "<power approximation>" << std::endl;
+        std::string eq = std::to_string(a) + "ln(x) + " + std::to_string(b);
 
-    Coefficients cf = approx_power(xs, ys);
-    float a = cf.first;
-    float b = cf.second;
+        out << "<TABLE>" << std::endl;
+        printApproximationTable(eq, xs, ys, phi_of_x, out, tableRows);
 
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * std::pow(x, b);
-    };
+        out << "We got a = " << a << " and b = " << b << std::endl;
+        out << "Deviation measure for log approximation = " << fit.deviation << std::endl;
+        out << "Standard deviation for log approximation (δ)= " << fit.standardDeviation << std::endl;
+        out << "log approximation [END]" << std::endl;
+    }
 
-    std::vector<float> phi;
-    for (float x : xs) {
-        phi.push_back(phi_of_x(x));
+    void report(const FitResult &fit, const Points &xs, const Points &ys, const Moments &moments, std::ostream &out,
+                size_t tableRows) {
+        switch (fit.model) {
+            case Model::Lineal: return reportLineal(fit, xs, ys, moments, out, tableRows);
+            case Model::Quadratic: return reportQuadratic(fit, xs, ys, out, tableRows);
+            case Model::Qube: return reportQube(fit, xs, ys, out, tableRows);
+            case Model::Power: return reportPower(fit, xs, ys, out, tableRows);
+            case Model::Exp: return reportExp(fit, xs, ys, out, tableRows);
+            case Model::Log: return reportLog(fit, xs, ys, out, tableRows);
+        }
     }
+}
 
-    std::string eq = std::to_string(a) + "x^" + std::to_string(b);
-    const std::vector<std::string> HEADERS = {"i", "x", "y", eq, "epsilon"};
-    std::vector<std::vector<std::string>> LINES;
+FitResult process_lineal(Points &xs, Points &ys, const Moments &moments, std::ostream &out, size_t tableRows) {
+    FitResult fit = fit_model(Model::Lineal, xs.data(), ys.data(), xs.size(), moments, LogColumns());
+    reportLineal(fit, xs, ys, moments, out, tableRows);
+    return fit;
+}
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        std::vector<std::string> LINE;
+FitResult process_quadratic(Points &xs, Points &ys, const Moments &moments, std::ostream &out, size_t tableRows) {
+    FitResult fit = fit_model(Model::Quadratic, xs.data(), ys.data(), xs.size(), moments, LogColumns());
+    reportQuadratic(fit, xs, ys, out, tableRows);
+    return fit;
+}
 
-        LINE.push_back(std::to_string(i + 1));
-        LINE.push_back(std::to_string(xs[i]));
-        LINE.push_back(std::to_string(ys[i]));
-        LINE.push_back(std::to_string(phi[i]));
-        LINE.push_back(std::to_string(std::abs(phi[i] - ys[i])));
-        LINES.push_back(LINE);
-    }
+FitResult process_qube(Points &xs, Points &ys, const Moments &moments, std::ostream &out, size_t tableRows) {
+    FitResult fit = fit_model(Model::Qube, xs.data(), ys.data(), xs.size(), moments, LogColumns());
+    reportQube(fit, xs, ys, out, tableRows);
+    return fit;
+}
+
+FitResult process_power(Points &xs, Points &ys, const LogColumns &logs, std::ostream &out, size_t tableRows,
+                        bool refine) {
+    FitResult fit = fit_model(Model::Power, xs.data(), ys.data(), xs.size(), Moments(), logs, refine);
+    reportPower(fit, xs, ys, out, tableRows);
+    return fit;
+}
 
-    std::cout << "<TABLE>" << std::endl;
-    printTable(HEADERS, LINES);
+FitResult process_exp(Points &xs, Points &ys, const LogColumns &logs, std::ostream &out, size_t tableRows,
+                      bool refine) {
+    FitResult fit = fit_model(Model::Exp, xs.data(), ys.data(), xs.size(), Moments(), logs, refine);
+    reportExp(fit, xs, ys, out, tableRows);
+    return fit;
+}
 
-    std::cout << "We got a = " << a << " and b = " << b << std::endl;
+FitResult process_log(Points &xs, Points &ys, const LogColumns &logs, std::ostream &out, size_t tableRows) {
+    FitResult fit = fit_model(Model::Log, xs.data(), ys.data(), xs.size(), Moments(), logs);
+    reportLog(fit, xs, ys, out, tableRows);
+    return fit;
+}
 
-    float powerDeviation = deviation_power(a, b, xs, ys);
-    std::cout << "Deviation measure for power approximation = " << powerDeviation << std::endl;
+FitResult fit_coefficients(Model model, const float *xs, const float *ys, size_t n, const Moments &moments,
+                           const LogColumns &logs, bool refine) {
+    switch (model) {
+        case Model::Lineal: {
+            Coefficients cf = approx_lineal(moments);
+            return {model, {cf.first, cf.second}};
+        }
+        case Model::Quadratic: {
+            Polynomial p = quadratic_approximation(moments);
+            return {model, p.coefficients, p.scaling};
+        }
+        case Model::Qube: {
+            Polynomial p = cube_approximation(moments);
+            return {model, p.coefficients, p.scaling};
+        }
+        case Model::Power: {
+            Coefficients cf = approx_power(logs);
+            if (refine) {
+                cf = refine_power(cf.first, cf.second, logs, ys);
+            }
+            return {model, {cf.first, cf.second}};
+        }
+        case Model::Exp: {
+            Coefficients cf = approx_exponential(xs, logs);
+            if (refine) {
+                cf = refine_exponential(cf.first, cf.second, xs, ys, n);
+            }
+            return {model, {cf.first, cf.second}};
+        }
+        case Model::Log: {
+            Coefficients cf = approx_log(ys, logs);
+            return {model, {cf.first, cf.second}};
+        }
+    }
 
-    size_t n = xs.size();
-    float powerStandardDeviation = standard_deviation(powerDeviation, n);
-    std::cout << "Standard deviation for power approximation (δ)= " << powerStandardDeviation << std::endl;
+    throw std::runtime_error("Unknown approximation model!");
+}
 
-    return powerStandardDeviation;
+FitResult fit_model(Model model, const float *xs, const float *ys, size_t n, const Moments &moments,
+                    const LogColumns &logs, bool refine) {
+    std::vector<FitResult> fit = {fit_coefficients(model, xs, ys, n, moments, logs, refine)};
+    score_fits(fit, xs, ys, n, logs, moments, true);
+    return fit.front();
 }
 
-float process_exp(Points &xs, Points &ys) {
-    std::cout << "<exp approximation>" << std::endl;
+FitResult process_model(Model model, Points &xs, Points &ys, const Moments &moments, const LogColumns &logs,
+                        std::ostream &out, size_t tableRows, bool refine) {
+    switch (model) {
+        case Model::Lineal: return process_lineal(xs, ys, moments, out, tableRows);
+        case Model::Quadratic: return process_quadratic(xs, ys, moments, out, tableRows);
+        case Model::Qube: return process_qube(xs, ys, moments, out, tableRows);
+        case Model::Power: return process_power(xs, ys, logs, out, tableRows, refine);
+        case Model::Exp: return process_exp(xs, ys, logs, out, tableRows, refine);
+        case Model::Log: return process_log(xs, ys, logs, out, tableRows);
+    }
+
+    throw std::runtime_error("Unknown approximation model!");
+}
 
-    Coefficients cf = approx_exponential(xs, ys);
-    float a = cf.first;
-    float b = cf.second;
+std::vector<FitResult> process_models(const std::vector<Model> &models, Points &xs, Points &ys, const Moments &moments,
+                                      const LogColumns &logs, bool parallel, std::ostream &out, size_t tableRows,
+                                      bool refine) {
+    std::vector<FitResult> result;
+    result.reserve(models.size());
 
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * std::exp(b * x);
-    };
+    std::unique_ptr<ThreadPool> pool;
+    if (parallel) {
+        pool = std::make_unique<ThreadPool>(
+                std::min<size_t>(models.size(), std::max(1u, std::thread::hardware_concurrency())));
+    }
 
-    std::vector<float> phi;
-    for (float x : xs) {
-        phi.push_back(phi_of_x(x));
+    /* the coefficients of every model first, then one pass over the points scores them all */
+    if (!parallel) {
+        for (Model model : models) {
+            result.push_back(fit_coefficients(model, xs.data(), ys.data(), xs.size(), moments, logs, refine));
+        }
+    } else {
+        std::vector<std::future<FitResult>> fits;
+        fits.reserve(models.size());
+
+        for (Model model : models) {
+            fits.push_back(pool->submit([&, model]() {
+                return fit_coefficients(model, xs.data(), ys.data(), xs.size(), moments, logs, refine);
+            }));
+        }
+
+        for (std::future<FitResult> &fit : fits) {
+            result.push_back(fit.get());
+        }
     }
 
-    std::string eq = std::to_string(a) + "e^("  + std::to_string(b) + "x)";
-    const std::vector<std::string> HEADERS = {"i", "x", "y", eq, "epsilon"};
-    std::vector<std::vector<std::string>> LINES;
+    score_fits(result, xs.data(), ys.data(), xs.size(), logs, moments, true);
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        std::vector<std::string> LINE;
+    if (!parallel) {
+        for (const FitResult &fit : result) {
+            report(fit, xs, ys, moments, out, tableRows);
+        }
 
-        LINE.push_back(std::to_string(i + 1));
-        LINE.push_back(std::to_string(xs[i]));
-        LINE.push_back(std::to_string(ys[i]));
-        LINE.push_back(std::to_string(phi[i]));
-        LINE.push_back(std::to_string(std::abs(phi[i] - ys[i])));
-        LINES.push_back(LINE);
+        return result;
     }
 
-    std::cout << "<TABLE>" << std::endl;
-    printTable(HEADERS, LINES);
+    std::vector<std::ostringstream> reports(result.size());
+    std::vector<std::future<void>> written;
+    written.reserve(result.size());
+
+    for (size_t i = 0; i < result.size(); i++) {
+        written.push_back(pool->submit([&, i]() {
+            report(result[i], xs, ys, moments, reports[i], tableRows);
+        }));
+    }
 
-    std::cout << "We got a = " << a << " and b = " << b << std::endl;
+    for (size_t i = 0; i < result.size(); i++) {
+        written[i].get();
+        out << reports[i].str();
+    }
 
-    float exponentialDeviation = deviation_exponential(a, b, xs, ys);
-    std::cout << "Deviation measure for exponential approximation = " << exponentialDeviation << std::endl;
+    return result;
+}
 
-    size_t e_n = xs.size();
-    float exponentialStandardDeviation = standard_deviation(exponentialDeviation, e_n);
-    std::cout << "Standard deviation for exponential approximation (δ)= " << exponentialStandardDeviation << std::endl;
+std::vector<FitResult> fit_models(const std::vector<Model> &models, const Points &xs, const Points &ys,
+                                  const Moments &moments, const LogColumns &logs, bool parallel, bool refine) {
+    if (xs.size() != ys.size()) {
+        throw std::runtime_error("The number of points x and y don't match!");
+    }
 
-    return exponentialStandardDeviation;
+    return fit_models(models, xs.data(), ys.data(), xs.size(), moments, logs, parallel, refine);
 }
 
-float process_log(Points &xs, Points &ys) {
-    std::cout << "<log approximation>" << std::endl;
+std::vector<FitResult> fit_models(const std::vector<Model> &models, const float *xs, const float *ys, size_t n,
+                                  const Moments &moments, const LogColumns &logs, bool parallel, bool refine) {
+    std::vector<FitResult> result;
+    result.reserve(models.size());
+
+    if (!parallel) {
+        for (Model model : models) {
+            result.push_back(quietFit(model, xs, ys, n, moments, logs, refine));
+        }
+
+        score_fits(result, xs, ys, n, logs, moments, true);
+        return result;
+    }
 
-    Coefficients cf = approx_log(xs, ys);
-    float a = cf.first;
-    float b = cf.second;
+    std::vector<std::future<FitResult>> fits;
+    fits.reserve(models.size());
 
-    auto phi_of_x = [a, b](float x) -> float {
-        return a * std::log(x) + b;
-    };
+    ThreadPool pool(std::min<size_t>(models.size(), std::max(1u, std::thread::hardware_concurrency())));
+    for (Model model : models) {
+        fits.push_back(pool.submit([&, model]() {
+            return quietFit(model, xs, ys, n, moments, logs, refine);
+        }));
+    }
 
-    std::vector<float> phi;
-    for (float x : xs) {
-        phi.push_back(phi_of_x(x));
+    for (std::future<FitResult> &fit : fits) {
+        result.push_back(fit.get());
     }
 
-    std::string eq = std::to_string(a) + "ln(x) + " + std::to_string(b);
-    const std::vector<std::string> HEADERS = {"i", "x", "y", eq, "epsilon"};
-    std::vector<std::vector<std::string>> LINES;
+    score_fits(result, xs, ys, n, logs, moments, true);
+    return result;
+}
 
-    for (size_t i = 0; i < xs.size(); i++) {
-        std::vector<std::string> LINE;
+const FitResult *best_fit(const std::vector<FitResult> &fits) {
+    const FitResult *best = nullptr;
 
-        LINE.push_back(std::to_string(i + 1));
-        LINE.push_back(std::to_string(xs[i]));
-        LINE.push_back(std::to_string(ys[i]));
-        LINE.push_back(std::to_string(phi[i]));
-        LINE.push_back(std::to_string(std::abs(phi[i] - ys[i])));
-        LINES.push_back(LINE);
+    for (const FitResult &fit : fits) {
+        if (!std::isnan(fit.standardDeviation) && (best == nullptr || fit.standardDeviation < best->standardDeviation)) {
+            best = &fit;
+        }
     }
 
-    std::cout << "<TABLE>" << std::endl;
-    printTable(HEADERS, LINES);
+    return best;
+}
+
+void write_fits(const std::vector<FitResult> &fits, const Moments &moments, OutputFormat format, std::ostream &out,
+                const std::vector<CrossValidation> &validations) {
+    const FitResult *best = best_fit(fits);
+
+    /* validations go with fits one to one, then they choose the best fit instead of δ */
+    bool validated = !validations.empty();
+    if (validated) {
+        const CrossValidation *bestValidation = best_validation(validations);
+        best = bestValidation == nullptr ? nullptr : &fits[bestValidation - validations.data()];
+    }
 
-    std::cout << "We got a = " << a << " and b = " << b << std::endl;
-    float logDeviation = deviation_log(a, b, xs, ys);
-    std::cout << "Deviation measure for log approximation = " << logDeviation << std::endl;
+    if (format == OutputFormat::Csv) {
+        out << "model,best,sse,sd,c0,c1,c2,c3,max_error,r2,adj_r2,aic,bic" << (validated ? ",cv_sd\n" : "\n");
+
+        for (size_t f = 0; f < fits.size(); f++) {
+            const FitResult &fit = fits[f];
+
+            out << modelName(fit.model) << ',' << (&fit == best ? 1 : 0) << ',';
+            writeNumber(out, fit.deviation, format);
+            out << ',';
+            writeNumber(out, fit.standardDeviation, format);
+
+            std::vector<float> coefficients = reportedCoefficients(fit);
+            for (size_t i = 0; i < 4; i++) {
+                out << ',';
+                if (i < coefficients.size()) {
+                    writeNumber(out, coefficients[i], format);
+                }
+            }
+            out << ',';
+            writeNumber(out, fit.maxError, format);
+            writeDiagnostics(out, diagnose(fit.deviation, fit.coefficients.size(), moments), format);
+            if (validated) {
+                out << ',';
+                writeNumber(out, validations[f].standardDeviation, format);
+            }
+            out << '\n';
+        }
+
+        out.flush();
+        return;
+    }
 
-    size_t l_n = xs.size();
-    float logStandardDeviation = standard_deviation(logDeviation, l_n);
-    std::cout << "Standard deviation for log approximation (δ)= " << logStandardDeviation << std::endl;
-    std::cout << "log approximation [END]" << std::endl;
+    out << "{\"n\": " << moments.n << ", \"best\": ";
+    if (best != nullptr) {
+        out << '"' << modelName(best->model) << '"';
+    } else {
+        out << "null";
+    }
+    if (validated) {
+        out << ", \"cv_folds\": " << validations.front().folds;
+    }
+    out << ", \"models\": [";
+
+    for (size_t i = 0; i < fits.size(); i++) {
+        const FitResult &fit = fits[i];
+
+        std::vector<float> coefficients = reportedCoefficients(fit);
+        out << (i == 0 ? "\n" : ",\n") << "  {\"model\": \"" << modelName(fit.model) << "\", \"coefficients\": [";
+        for (size_t k = 0; k < coefficients.size(); k++) {
+            if (k > 0) {
+                out << ", ";
+            }
+            writeNumber(out, coefficients[k], format);
+        }
+        out << ']';
+        /* the polynomial as it was solved and scored, the coefficients of x are rounded from it */
+        if (!fit.coefficients.empty() && (fit.model == Model::Quadratic || fit.model == Model::Qube)) {
+            out << ", \"center\": ";
+            writeNumber(out, static_cast<float>(fit.scaling.center), format);
+            out << ", \"scale\": ";
+            writeNumber(out, static_cast<float>(fit.scaling.scale), format);
+            out << ", \"t_coefficients\": [";
+            for (size_t k = 0; k < fit.coefficients.size(); k++) {
+                if (k > 0) {
+                    out << ", ";
+                }
+                writeNumber(out, fit.coefficients[k], format);
+            }
+            out << ']';
+        }
+        out << ", \"sse\": ";
+        writeNumber(out, fit.deviation, format);
+        out << ", \"sd\": ";
+        writeNumber(out, fit.standardDeviation, format);
+        out << ", \"max_error\": ";
+        writeNumber(out, fit.maxError, format);
+        writeDiagnostics(out, diagnose(fit.deviation, fit.coefficients.size(), moments), format);
+        if (validated) {
+            out << ", \"cv_sd\": ";
+            writeNumber(out, validations[i].standardDeviation, format);
+        }
+        out << '}';
+    }
 
-    return logStandardDeviation;
-}
\ No newline at end of file
+    out << "\n]}\n";
+    out.flush();
+}
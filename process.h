@@ -2,22 +2,99 @@
 #define FUNCTION_APPROXIMATION_PROCESS_H
 
 #include "approximation.h"
+#include "cross_validation.h"
 #include "deviation.h"
 #include "table.h"
+#include "model.h"
 
 typedef std::vector<float> Points;
 typedef std::pair<float, float> Coefficients;
 
-float process_lineal(Points &xs, Points &ys);
+/*
+ * the process_* functions report the fit of one model with a table of every point;
+ * tableRows > 0 keeps only the first and the last rows of the table, tableRows in total.
+ * refine runs the Levenberg–Marquardt refinement (see refine.h) after the linearized power and exp fits.
+ * Power, exp and log read their logarithms from logs, taken once for the points (see log_columns.h)
+ */
+FitResult process_lineal(Points &xs, Points &ys, const Moments &moments, std::ostream &out = std::cout,
+                         size_t tableRows = 0);
 
-float process_quadratic(Points &xs, Points &ys);
+FitResult process_quadratic(Points &xs, Points &ys, const Moments &moments, std::ostream &out = std::cout,
+                            size_t tableRows = 0);
 
-float process_qube(Points &xs, Points &ys);
+FitResult process_qube(Points &xs, Points &ys, const Moments &moments, std::ostream &out = std::cout,
+                       size_t tableRows = 0);
 
-float process_power(Points &xs, Points &ys);
+FitResult process_power(Points &xs, Points &ys, const LogColumns &logs, std::ostream &out = std::cout,
+                        size_t tableRows = 0, bool refine = false);
 
-float process_exp(Points &xs, Points &ys);
+FitResult process_exp(Points &xs, Points &ys, const LogColumns &logs, std::ostream &out = std::cout,
+                      size_t tableRows = 0, bool refine = false);
 
-float process_log(Points &xs, Points &ys);
+FitResult process_log(Points &xs, Points &ys, const LogColumns &logs, std::ostream &out = std::cout,
+                      size_t tableRows = 0);
+
+/*
+ * the coefficients of the model only (with the scaling of a polynomial one), S and the rest are left unscored;
+ * throws when the model can not be fitted
+ */
+FitResult fit_coefficients(Model model, const float *xs, const float *ys, size_t n, const Moments &moments,
+                                    const LogColumns &logs, bool refine = false);
+
+/* fits the model and scores it (see scoring.h) without reporting anything, moments must be of degree 3 or higher */
+FitResult fit_model(Model model, const float *xs, const float *ys, size_t n, const Moments &moments,
+                    const LogColumns &logs, bool refine = false);
+
+/* runs process_* of the given model, moments must be of degree 3 or higher */
+FitResult process_model(Model model, Points &xs, Points &ys, const Moments &moments, const LogColumns &logs,
+                        std::ostream &out = std::cout, size_t tableRows = 0, bool refine = false);
+
+/*
+ * processes every model and returns their fits in the order of models.
+ * All the models are fitted first and scored together by one pass of score_fits, then reported;
+ * S of the polynomial models comes from the moments wherever polynomial_sse has it (see diagnostics.h).
+ * In parallel mode all models run at once on a thread pool, each one reporting into its own buffer;
+ * the buffers are printed to out in the order of models, so the output is the same as in serial mode.
+ */
+std::vector<FitResult> process_models(const std::vector<Model> &models, Points &xs, Points &ys, const Moments &moments,
+                                      const LogColumns &logs, bool parallel, std::ostream &out = std::cout,
+                                      size_t tableRows = 0, bool refine = false);
+
+/* machine-readable output of the quiet mode */
+enum class OutputFormat {
+    Json,
+    Csv
+};
+
+/*
+ * fits every model and scores them all in one pass, so not a single per point string is built;
+ * S of the polynomial models comes from the moments as in process_models, the pass gives their max error.
+ * A model whose fit fails is kept with no coefficients and nan deviations.
+ * In parallel mode the models are fitted at once on a thread pool.
+ */
+std::vector<FitResult> fit_models(const std::vector<Model> &models, const Points &xs, const Points &ys,
+                                  const Moments &moments, const LogColumns &logs, bool parallel,
+                                  bool refine = false);
+
+/* the same for n points given as columns, a mapped binary file for one */
+std::vector<FitResult> fit_models(const std::vector<Model> &models, const float *xs, const float *ys, size_t n,
+                                  const Moments &moments, const LogColumns &logs, bool parallel,
+                                  bool refine = false);
+
+/* the fit with the smallest standard deviation, failed fits are skipped; nullptr if every fit failed */
+const FitResult *best_fit(const std::vector<FitResult> &fits);
+
+/*
+ * writes the number of points, the chosen model and the coefficients, S, δ, the largest error
+ * and the diagnostics (see diagnostics.h, from S and the moments) of every fit.
+ * CSV has one record per model: model,best,sse,sd,c0,c1,c2,c3,max_error,r2,adj_r2,aic,bic
+ * (coefficients in FitResult order, those of x: see reportedCoefficients). JSON gives a quadratic or qube fit
+ * as it was solved as well: center, scale and t_coefficients (see Polynomial)
+ *
+ * With validations (one per fit, in the same order, see cross_validation.h) every fit also gets
+ * its cross-validated δ as cv_sd, and the best fit is the one with the smallest cv_sd.
+ */
+void write_fits(const std::vector<FitResult> &fits, const Moments &moments, OutputFormat format,
+                std::ostream &out = std::cout, const std::vector<CrossValidation> &validations = {});
 
 #endif //FUNCTION_APPROXIMATION_PROCESS_H
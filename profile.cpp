@@ -0,0 +1,154 @@
+#include "profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace profile {
+    std::atomic<bool> active{false};
+
+    namespace {
+        std::atomic<Slot *> slots{nullptr};
+        std::atomic<Format> exitFormat{Format::Text};
+
+        void reportAtExit() {
+            /* the report allocates, which should not show up in it */
+            active = false;
+            report(std::cerr, exitFormat.load());
+        }
+
+        /* a snapshot of one slot, the atomics keep counting while the report is written */
+        struct Entry {
+            std::string name;
+            bool timer;
+            uint64_t calls;
+            uint64_t value;
+        };
+
+        std::vector<Entry> snapshot() {
+            std::vector<Entry> entries;
+            for (Slot *slot = slots.load(); slot != nullptr; slot = slot->next) {
+                uint64_t calls = slot->calls.load(std::memory_order_relaxed);
+                if (calls == 0) {
+                    continue;
+                }
+
+                /* a name used in several places (or template instances) is reported once */
+                auto same = std::find_if(entries.begin(), entries.end(), [slot](const Entry &e) {
+                    return e.timer == slot->timer && e.name == slot->name;
+                });
+                if (same == entries.end()) {
+                    entries.push_back({slot->name, slot->timer, 0, 0});
+                    same = entries.end() - 1;
+                }
+
+                same->calls += calls;
+                same->value += slot->value.load(std::memory_order_relaxed);
+            }
+
+            /* the most expensive stages first, counters by name */
+            std::sort(entries.begin(), entries.end(), [](const Entry &l, const Entry &r) {
+                if (l.timer != r.timer) {
+                    return l.timer;
+                }
+                return l.timer ? l.value > r.value : l.name < r.name;
+            });
+
+            return entries;
+        }
+    }
+
+    Slot::Slot(const char *name, bool timer) : name(name), timer(timer) {
+        /* slots are only ever added, so a lock-free push is enough */
+        next = slots.load();
+        while (!slots.compare_exchange_weak(next, this)) {
+        }
+    }
+
+    void enable(Format format) {
+        exitFormat = format;
+        if (!active.exchange(true)) {
+            std::atexit(reportAtExit);
+        }
+    }
+
+    void report(std::ostream &out, Format format) {
+        std::vector<Entry> entries = snapshot();
+        char line[160];
+
+        if (format == Format::Json) {
+            out << "{\"timers\": [";
+            bool first = true;
+            for (const Entry &e : entries) {
+                if (e.timer) {
+                    std::snprintf(line, sizeof(line), "%s\n  {\"name\": \"%s\", \"calls\": %llu, \"total_ns\": %llu}",
+                                  first ? "" : ",", e.name.c_str(), (unsigned long long) e.calls,
+                                  (unsigned long long) e.value);
+                    out << line;
+                    first = false;
+                }
+            }
+            out << "\n], \"counters\": [";
+            first = true;
+            for (const Entry &e : entries) {
+                if (!e.timer) {
+                    std::snprintf(line, sizeof(line), "%s\n  {\"name\": \"%s\", \"calls\": %llu, \"value\": %llu}",
+                                  first ? "" : ",", e.name.c_str(), (unsigned long long) e.calls,
+                                  (unsigned long long) e.value);
+                    out << line;
+                    first = false;
+                }
+            }
+            out << "\n]}\n";
+        } else {
+            std::snprintf(line, sizeof(line), "%-28s %12s %14s %14s\n", "stage", "calls", "total ms", "avg us");
+            out << line;
+            for (const Entry &e : entries) {
+                if (e.timer) {
+                    std::snprintf(line, sizeof(line), "%-28s %12llu %14.3f %14.3f\n", e.name.c_str(),
+                                  (unsigned long long) e.calls, e.value / 1e6, e.value / 1e3 / e.calls);
+                    out << line;
+                }
+            }
+
+            std::snprintf(line, sizeof(line), "%-28s %12s %14s\n", "counter", "calls", "value");
+            out << line;
+            for (const Entry &e : entries) {
+                if (!e.timer) {
+                    std::snprintf(line, sizeof(line), "%-28s %12llu %14llu\n", e.name.c_str(),
+                                  (unsigned long long) e.calls, (unsigned long long) e.value);
+                    out << line;
+                }
+            }
+        }
+
+        out.flush();
+    }
+}
+
+#ifdef FUNCTION_APPROXIMATION_PROFILE
+/*
+ * bytes allocated are counted by replacing the global allocation functions,
+ * the array and nothrow forms of the standard library forward to these two
+ */
+void *operator new(std::size_t size) {
+    PROFILE_COUNT("bytes_allocated", size);
+
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
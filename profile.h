@@ -0,0 +1,95 @@
+#ifndef FUNCTION_APPROXIMATION_PROFILE_H
+#define FUNCTION_APPROXIMATION_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+/*
+ * Stage timers and counters of the hot paths.
+ *
+ * PROFILE_SCOPE("name") times the rest of the enclosing block, PROFILE_COUNT("name", amount) adds to a counter.
+ * Both compile to nothing unless FUNCTION_APPROXIMATION_PROFILE is defined, and when compiled in they cost
+ * a relaxed load of one flag until profile::enable() turns collection on (main does so for --profile).
+ * Timers are inclusive: a stage that calls another stage also counts the time spent there.
+ */
+namespace profile {
+    enum class Format {
+        Text,
+        Json
+    };
+
+    /* a named timer or counter, created on first use and registered for the report until exit */
+    struct Slot {
+        const char *name;
+        bool timer;
+        std::atomic<uint64_t> calls{0};
+        /* nanoseconds for a timer, the sum of the amounts for a counter */
+        std::atomic<uint64_t> value{0};
+        Slot *next = nullptr;
+
+        Slot(const char *name, bool timer);
+    };
+
+    extern std::atomic<bool> active;
+
+    inline bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    /* turns collection on, the summary is written to std::cerr at exit */
+    void enable(Format format);
+
+    void report(std::ostream &out, Format format);
+
+    inline void count(Slot &slot, uint64_t amount) {
+        slot.calls.fetch_add(1, std::memory_order_relaxed);
+        slot.value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    class Scope {
+    public:
+        explicit Scope(Slot &slot) : slot(enabled() ? &slot : nullptr) {
+            if (this->slot != nullptr) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Scope() {
+            if (slot != nullptr) {
+                std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+                count(*slot, static_cast<uint64_t>(elapsed.count()));
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Slot *slot;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#ifdef FUNCTION_APPROXIMATION_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#define PROFILE_SCOPE(name) \
+    static profile::Slot PROFILE_CONCAT(profileSlot_, __LINE__)(name, true); \
+    profile::Scope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileSlot_, __LINE__))
+
+#define PROFILE_COUNT(name, amount) \
+    do { \
+        if (profile::enabled()) { \
+            static profile::Slot profileSlot(name, false); \
+            profile::count(profileSlot, static_cast<uint64_t>(amount)); \
+        } \
+    } while (0)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_COUNT(name, amount) do {} while (0)
+#endif
+
+#endif //FUNCTION_APPROXIMATION_PROFILE_H
@@ -0,0 +1,175 @@
+#include "refine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "profile.h"
+#include "simd.h"
+#include "summation.h"
+#include "vecmath.h"
+
+namespace {
+    using namespace simd;
+
+    const int MAX_ITERATIONS = 50;
+
+    /* steps below this relative size are lost in float coefficients anyway */
+    const double STEP_TOLERANCE = 1e-6;
+
+    const double INITIAL_DAMPING = 1e-3;
+    const double MAX_DAMPING = 1e12;
+
+    /*
+     * everything a step needs at one point {a, b}, with g_i = e^(b * t_i) and ε_i = a * g_i - y_i:
+     * J^T * J = [gg, a * tgg; a * tgg, a^2 * ttgg], J^T * ε = [ge, a * tge]
+     */
+    struct Normal {
+        double gg = 0;
+        double tgg = 0;
+        double ttgg = 0;
+        double ge = 0;
+        double tge = 0;
+        double sse = 0;
+    };
+
+    /* one pass for all six sums: float lanes within a block of SUM_BLOCK points, the blocks added up in double */
+    Normal evaluate(float a, float b, const float *ts, const float *ys, size_t n) {
+        static_assert(SUM_BLOCK % WIDTH == 0, "summation blocks must hold whole vectors");
+
+        Normal s;
+        Vec va = set1(a);
+        Vec vb = set1(b);
+        size_t vectorEnd = n - n % WIDTH;
+
+        size_t i = 0;
+        while (i < vectorEnd) {
+            size_t end = std::min(vectorEnd, i + SUM_BLOCK);
+
+            Vec gg = set1(0.0f), tgg = set1(0.0f), ttgg = set1(0.0f);
+            Vec ge = set1(0.0f), tge = set1(0.0f), sse = set1(0.0f);
+            for (; i < end; i += WIDTH) {
+                Vec t = load(ts + i);
+                Vec g = vexp(mul(vb, t));
+                Vec e = sub(mul(va, g), load(ys + i));
+                Vec tg = mul(t, g);
+
+                gg = fmadd(g, g, gg);
+                tgg = fmadd(tg, g, tgg);
+                ttgg = fmadd(tg, tg, ttgg);
+                ge = fmadd(g, e, ge);
+                tge = fmadd(tg, e, tge);
+                sse = fmadd(e, e, sse);
+            }
+
+            s.gg += reduce(gg);
+            s.tgg += reduce(tgg);
+            s.ttgg += reduce(ttgg);
+            s.ge += reduce(ge);
+            s.tge += reduce(tge);
+            s.sse += reduce(sse);
+        }
+
+        for (; i < n; i++) {
+            float g = sexp(b * ts[i]);
+            double e = a * g - ys[i];
+            double t = ts[i];
+
+            s.gg += g * g;
+            s.tgg += t * g * g;
+            s.ttgg += t * t * g * g;
+            s.ge += g * e;
+            s.tge += t * g * e;
+            s.sse += e * e;
+        }
+
+        return s;
+    }
+
+    std::pair<float, float> levenberg_marquardt(float a, float b, const float *ts, const float *ys, size_t n) {
+        PROFILE_SCOPE("levenberg_marquardt");
+
+        if (n == 0 || !std::isfinite(a) || !std::isfinite(b)) {
+            return {a, b};
+        }
+
+        Normal current = evaluate(a, b, ts, ys, n);
+        if (!std::isfinite(current.sse)) {
+            return {a, b};
+        }
+
+        double lambda = INITIAL_DAMPING;
+        for (int iteration = 0; iteration < MAX_ITERATIONS && lambda <= MAX_DAMPING; iteration++) {
+            PROFILE_COUNT("refine_iterations", 1);
+
+            double j00 = current.gg;
+            double j01 = a * current.tgg;
+            double j11 = static_cast<double>(a) * a * current.ttgg;
+            double r0 = current.ge;
+            double r1 = a * current.tge;
+
+            /* damped 2 x 2 system by Cramer's rule */
+            double m00 = j00 * (1 + lambda);
+            double m11 = j11 * (1 + lambda);
+            double det = m00 * m11 - j01 * j01;
+            if (!(det > 0)) {
+                lambda *= 10;
+                continue;
+            }
+
+            double da = -(r0 * m11 - r1 * j01) / det;
+            double db = -(m00 * r1 - j01 * r0) / det;
+
+            /* a step this small no longer changes the float coefficients: converged */
+            if (std::abs(da) <= STEP_TOLERANCE * (std::abs(a) + STEP_TOLERANCE)
+                && std::abs(db) <= STEP_TOLERANCE * (std::abs(b) + STEP_TOLERANCE)) {
+                break;
+            }
+
+            float nextA = static_cast<float>(a + da);
+            float nextB = static_cast<float>(b + db);
+            Normal next = evaluate(nextA, nextB, ts, ys, n);
+
+            if (!(next.sse < current.sse)) {
+                lambda *= 10;
+                continue;
+            }
+
+            a = nextA;
+            b = nextB;
+            current = next;
+            lambda = std::max(lambda / 10, 1e-12);
+        }
+
+        return {a, b};
+    }
+}
+
+std::pair<float, float> refine_exponential(float a, float b, const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("refine_exponential");
+    PROFILE_COUNT("points", n);
+
+    return levenberg_marquardt(a, b, xs, ys, n);
+}
+
+std::pair<float, float> refine_power(float a, float b, const float *xs, const float *ys, size_t n) {
+    PROFILE_SCOPE("refine_power");
+    PROFILE_COUNT("points", n);
+
+    /* x^b = e^(b * ln x), ln x does not depend on a or b and is taken once */
+    std::vector<float> ts(n);
+    log_column(xs, ts.data(), n);
+
+    return levenberg_marquardt(a, b, ts.data(), ys, n);
+}
+
+std::pair<float, float> refine_power(float a, float b, const LogColumns &columns, const float *ys) {
+    PROFILE_SCOPE("refine_power");
+    PROFILE_COUNT("points", columns.n);
+
+    if (!columns.hasLnX()) {
+        return {a, b};
+    }
+
+    return levenberg_marquardt(a, b, columns.lnX.data(), ys, columns.n);
+}
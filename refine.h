@@ -0,0 +1,33 @@
+#ifndef FUNCTION_APPROXIMATION_REFINE_H
+#define FUNCTION_APPROXIMATION_REFINE_H
+
+#include <cstddef>
+#include <utility>
+
+#include "log_columns.h"
+
+/*
+ * Levenberg–Marquardt refinement of the exponential and the power fit.
+ *
+ * approx_exponential and approx_power fit a line to ln y, so they minimize Σ(ln φ(x_i) - ln y_i)^2
+ * and not S = Σ(φ(x_i) - y_i)^2, which is what the deviation measures: large y get too little weight.
+ * The refinement starts at the linearized {a, b} and minimizes S itself. Both models are
+ * φ = a * e^(b * t) with t = x or t = ln x, so they share one kernel with the analytic Jacobian
+ *
+ * dφ/da = e^(b * t), dφ/db = a * t * e^(b * t)
+ *
+ * One vectorized pass over the points gives S, J^T * J and J^T * ε at once; a step solves the 2 x 2
+ * damped system (J^T * J + λ * diag(J^T * J)) * δ = -J^T * ε. A step is taken only when it lowers S,
+ * so the result is never worse than the start; a few passes are usually enough.
+ *
+ * The log model a * ln(x) + b is linear in a and b, its least squares fit is already exact.
+ * A start that is not finite (y <= 0 for the linearization) is returned as it is.
+ */
+std::pair<float, float> refine_exponential(float a, float b, const float *xs, const float *ys, size_t n);
+
+std::pair<float, float> refine_power(float a, float b, const float *xs, const float *ys, size_t n);
+
+/* reads ln x from the columns instead of taking it again */
+std::pair<float, float> refine_power(float a, float b, const LogColumns &columns, const float *ys);
+
+#endif //FUNCTION_APPROXIMATION_REFINE_H
@@ -0,0 +1,263 @@
+#include "scoring.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "deviation.h"
+#include "diagnostics.h"
+#include "profile.h"
+#include "simd.h"
+#include "summation.h"
+#include "vecmath.h"
+
+namespace {
+    using namespace simd;
+
+    /*
+     * one fit being scored: its coefficients from the lowest power up (a and b for power and exp),
+     * the t = (x - center) * inverse a polynomial is in, S over the finished blocks,
+     * the largest and the smallest ε per lane and the same for the tail points;
+     * momentS when S is already known from the moments and only the max error is measured
+     */
+    struct Scored {
+        FitResult *fit = nullptr;
+        bool momentS = false;
+        float c[4] = {};
+        size_t degree = 0;
+        float center = 0;
+        float inverse = 1;
+        VecSum total;
+        Vec high = set1(0.0f);
+        Vec low = set1(0.0f);
+        float tail = 0;
+        float tailError = 0;
+    };
+
+    /*
+     * adds the squared errors of one block of count points (a multiple of WIDTH) to acc,
+     * us is what φ is a function of: x, or ln x for power and log
+     */
+    template<typename PhiVec>
+    void scoreBlock(const float *us, const float *ys, size_t count, PhiVec phi_vec, Scored &acc) {
+        /* two accumulators, so consecutive vectors do not wait for each other's fmadd */
+        Vec acc0 = set1(0.0f);
+        Vec acc1 = set1(0.0f);
+        Vec high = acc.high;
+        Vec low = acc.low;
+
+        size_t i = 0;
+        for (; i + 2 * WIDTH <= count; i += 2 * WIDTH) {
+            Vec e0 = sub(phi_vec(load(us + i)), load(ys + i));
+            Vec e1 = sub(phi_vec(load(us + i + WIDTH)), load(ys + i + WIDTH));
+            acc0 = fmadd(e0, e0, acc0);
+            acc1 = fmadd(e1, e1, acc1);
+            high = max(high, max(e0, e1));
+            low = min(low, min(e0, e1));
+        }
+        for (; i < count; i += WIDTH) {
+            Vec e = sub(phi_vec(load(us + i)), load(ys + i));
+            acc0 = fmadd(e, e, acc0);
+            high = max(high, e);
+            low = min(low, e);
+        }
+
+        acc.total.add(add(acc0, acc1));
+        acc.high = high;
+        acc.low = low;
+    }
+
+    /* Horner's scheme of a fixed degree in t of u, so the coefficients stay in registers over the block */
+    template<size_t Degree>
+    void scorePolynomial(const float *us, const float *ys, size_t count, Scored &acc) {
+        Vec cv[Degree + 1];
+        for (size_t k = 0; k <= Degree; k++) {
+            cv[k] = set1(acc.c[k]);
+        }
+        Vec center = set1(acc.center);
+        Vec inverse = set1(acc.inverse);
+
+        scoreBlock(us, ys, count, [&cv, center, inverse](Vec u) -> Vec {
+            Vec t = mul(sub(u, center), inverse);
+            Vec p = cv[Degree];
+            for (size_t k = Degree; k-- > 0;) {
+                p = fmadd(p, t, cv[k]);
+            }
+            return p;
+        }, acc);
+    }
+
+    /* φ = a * e^(b * u): exp with u = x, power with u = ln x */
+    void scoreExponent(float a, float b, const float *us, const float *ys, size_t count, Scored &acc) {
+        scoreBlock(us, ys, count, [a, b](Vec u) -> Vec {
+            return mul(set1(a), vexp(mul(set1(b), u)));
+        }, acc);
+    }
+
+    Scored scoredOf(FitResult &fit) {
+        const std::vector<float> &cf = fit.coefficients;
+
+        Scored scored;
+        scored.fit = &fit;
+        switch (fit.model) {
+            case Model::Lineal:
+            case Model::Log:
+                scored.c[0] = cf[1];
+                scored.c[1] = cf[0];
+                scored.degree = 1;
+                break;
+            case Model::Quadratic:
+            case Model::Qube:
+                std::copy(cf.begin(), cf.end(), scored.c);
+                scored.degree = cf.size() - 1;
+                scored.center = static_cast<float>(fit.scaling.center);
+                scored.inverse = fit.scaling.inverse();
+                break;
+            case Model::Power:
+            case Model::Exp:
+                scored.c[0] = cf[0];
+                scored.c[1] = cf[1];
+                break;
+        }
+
+        return scored;
+    }
+
+    bool needsLog(Model model) {
+        return model == Model::Power || model == Model::Log;
+    }
+
+    /* φ(x) of one fit for a tail point, with the same exp as the vectors */
+    float phi(const Scored &m, float x, float lnx) {
+        switch (m.fit->model) {
+            case Model::Power:
+                return m.c[0] * sexp(m.c[1] * lnx);
+            case Model::Exp:
+                return m.c[0] * sexp(m.c[1] * x);
+            default:
+                break;
+        }
+
+        float u = m.fit->model == Model::Log ? lnx : x;
+        float t = (u - m.center) * m.inverse;
+        float p = m.c[m.degree];
+        for (size_t k = m.degree; k-- > 0;) {
+            p = std::fma(p, t, m.c[k]);
+        }
+        return p;
+    }
+}
+
+void score_fits(std::vector<FitResult> &fits, const float *xs, const float *ys, size_t n, const LogColumns &logs) {
+    score_fits(fits, xs, ys, n, logs, Moments(), true);
+}
+
+void score_fits(std::vector<FitResult> &fits, const float *xs, const float *ys, size_t n, const LogColumns &logs,
+                const Moments &moments, bool maxErrors) {
+    PROFILE_SCOPE("score_fits");
+    PROFILE_COUNT("points", n);
+
+    static_assert(SUM_BLOCK % WIDTH == 0, "summation blocks must hold whole vectors");
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    std::vector<Scored> scored;
+    scored.reserve(fits.size());
+    bool logNeeded = false;
+    for (FitResult &fit : fits) {
+        if (fit.coefficients.empty()) {
+            fit.deviation = fit.standardDeviation = fit.maxError = nan;
+            continue;
+        }
+
+        /* polynomial_sse is nan for the other models, for moments of degree 0 and wherever it is not accurate */
+        float S = polynomial_sse(fit, moments);
+        if (!std::isnan(S)) {
+            fit.deviation = S;
+            fit.standardDeviation = standard_deviation(S, n);
+            fit.maxError = nan;
+            if (!maxErrors) {
+                continue;
+            }
+        }
+
+        scored.push_back(scoredOf(fit));
+        scored.back().momentS = !std::isnan(S);
+        logNeeded = logNeeded || needsLog(fit.model);
+    }
+
+    if (scored.empty()) {
+        return;
+    }
+
+    /* ln x comes from the columns, or is taken here a block at a time when they have none */
+    const float *lnXs = logNeeded && logs.hasLnX() && logs.n == n ? logs.lnX.data() : nullptr;
+    float lnBlock[SUM_BLOCK];
+
+    /*
+     * the points are read from memory once: every fit goes over a block while it is still in the cache,
+     * each with its own loop, so φ and the sums of a fit stay in registers
+     */
+    size_t vectorEnd = n - n % WIDTH;
+
+    for (size_t begin = 0; begin < vectorEnd; begin += SUM_BLOCK) {
+        size_t size = std::min(vectorEnd - begin, SUM_BLOCK);
+        const float *x = xs + begin;
+        const float *y = ys + begin;
+
+        const float *lnx = nullptr;
+        if (lnXs != nullptr) {
+            lnx = lnXs + begin;
+        } else if (logNeeded) {
+            log_column(x, lnBlock, size);
+            lnx = lnBlock;
+        }
+
+        for (Scored &m : scored) {
+            switch (m.fit->model) {
+                case Model::Lineal: scorePolynomial<1>(x, y, size, m); break;
+                case Model::Quadratic: scorePolynomial<2>(x, y, size, m); break;
+                case Model::Qube: scorePolynomial<3>(x, y, size, m); break;
+                case Model::Log: scorePolynomial<1>(lnx, y, size, m); break;
+                case Model::Power: scoreExponent(m.c[0], m.c[1], lnx, y, size, m); break;
+                case Model::Exp: scoreExponent(m.c[0], m.c[1], x, y, size, m); break;
+            }
+        }
+    }
+
+    for (size_t i = vectorEnd; i < n; i++) {
+        float lnx = !logNeeded ? 0.0f : lnXs != nullptr ? lnXs[i] : slog(xs[i]);
+
+        for (Scored &m : scored) {
+            float e = phi(m, xs[i], lnx) - ys[i];
+            m.tail = std::fma(e, e, m.tail);
+            m.tailError = std::max(m.tailError, std::abs(e));
+        }
+    }
+
+    for (Scored &m : scored) {
+        CompensatedSum S = m.total.total();
+        S.add(m.tail);
+
+        /* max |ε| = max(max ε, -min ε) */
+        float highs[WIDTH];
+        float lows[WIDTH];
+        store(highs, m.high);
+        store(lows, m.low);
+        float maxError = m.tailError;
+        for (size_t l = 0; l < WIDTH; l++) {
+            maxError = std::max(maxError, std::max(highs[l], -lows[l]));
+        }
+
+        FitResult &fit = *m.fit;
+        if (m.momentS) {
+            fit.maxError = maxError;
+            continue;
+        }
+
+        fit.deviation = S.value();
+        fit.standardDeviation = standard_deviation(fit.deviation, n);
+        /* a nan residual drops out of max, but it does make S nan */
+        fit.maxError = std::isnan(fit.deviation) ? nan : maxError;
+    }
+}
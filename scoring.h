@@ -0,0 +1,35 @@
+#ifndef FUNCTION_APPROXIMATION_SCORING_H
+#define FUNCTION_APPROXIMATION_SCORING_H
+
+#include <cstddef>
+#include <vector>
+
+#include "log_columns.h"
+#include "model.h"
+#include "moments.h"
+
+/*
+ * Scores every fitted candidate in a single pass over the points: for each fit
+ * S = Σ(φ(x_i) - y_i)^2, the largest |φ(x_i) - y_i| and δ = sqrt(S / n).
+ *
+ * Scoring the models one by one streams x and y from memory once per model; here every model goes
+ * over a block of SUM_BLOCK points while the block is still in the cache, so the points are read once
+ * whatever the number of models. ln x (for power and log) is read from the columns when they have it.
+ * S is summed like the sse_* kernels do (plain float within a block, compensated over the blocks),
+ * so both give the same S up to the last bits.
+ *
+ * Quadratic and qube are evaluated in the t of their scaling, as they were fitted (see Polynomial).
+ * A fit without coefficients (a failed fit) gets nan for all three.
+ */
+void score_fits(std::vector<FitResult> &fits, const float *xs, const float *ys, size_t n, const LogColumns &logs);
+
+/*
+ * the same, but S and δ of the lineal, quadratic and qube fits come from the moments of the points
+ * wherever polynomial_sse has them (see diagnostics.h), and only the fits it cannot score are summed
+ * over the points. Their max error does need the points: with maxErrors false the fits scored from
+ * the moments are left out of the pass and get nan for it, so ranking them costs nothing beyond the fit
+ */
+void score_fits(std::vector<FitResult> &fits, const float *xs, const float *ys, size_t n, const LogColumns &logs,
+                const Moments &moments, bool maxErrors);
+
+#endif //FUNCTION_APPROXIMATION_SCORING_H
@@ -0,0 +1,216 @@
+#ifndef FUNCTION_APPROXIMATION_SIMD_H
+#define FUNCTION_APPROXIMATION_SIMD_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define SIMD_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_NEON
+#endif
+
+/*
+ * the smallest set of vector operations the kernels need,
+ * every instruction set provides the same names so the kernels are written once.
+ * Int holds the same lanes as 32 bit integers and Mask the result of a lane by lane comparison,
+ * both are only there for the bit work of the transcendentals in vecmath.h
+ */
+namespace simd {
+#if defined(SIMD_AVX2)
+    constexpr const char *ISA = "avx2";
+    constexpr size_t WIDTH = 8;
+    typedef __m256 Vec;
+
+    inline Vec load(const float *p) { return _mm256_loadu_ps(p); }
+    inline void store(float *p, Vec v) { _mm256_storeu_ps(p, v); }
+    inline Vec set1(float v) { return _mm256_set1_ps(v); }
+    inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+    inline Vec fnmadd(Vec a, Vec b, Vec c) { return _mm256_fnmadd_ps(a, b, c); }
+    inline Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+    inline Vec sqrt(Vec v) { return _mm256_sqrt_ps(v); }
+
+    inline float reduce(Vec v) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+
+    typedef __m256i Int;
+    typedef __m256 Mask;
+
+    inline Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    inline Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+    inline Mask less(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    inline Mask greater(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    inline Mask equal(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    inline Mask unordered(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_UNORD_Q); }
+    inline Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    inline Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+
+    inline Int set1_int(int32_t v) { return _mm256_set1_epi32(v); }
+    inline Int round_to_int(Vec v) { return _mm256_cvtps_epi32(v); }
+    inline Vec to_float(Int v) { return _mm256_cvtepi32_ps(v); }
+    inline Int bits(Vec v) { return _mm256_castps_si256(v); }
+    inline Vec from_bits(Int v) { return _mm256_castsi256_ps(v); }
+    inline Int add_int(Int a, Int b) { return _mm256_add_epi32(a, b); }
+    inline Int sub_int(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+    inline Int and_int(Int a, Int b) { return _mm256_and_si256(a, b); }
+    inline Int or_int(Int a, Int b) { return _mm256_or_si256(a, b); }
+    template<int N> inline Int shift_left(Int v) { return _mm256_slli_epi32(v, N); }
+    template<int N> inline Int shift_right(Int v) { return _mm256_srai_epi32(v, N); }
+#elif defined(SIMD_SSE2)
+    constexpr const char *ISA = "sse2";
+    constexpr size_t WIDTH = 4;
+    typedef __m128 Vec;
+
+    inline Vec load(const float *p) { return _mm_loadu_ps(p); }
+    inline void store(float *p, Vec v) { _mm_storeu_ps(p, v); }
+    inline Vec set1(float v) { return _mm_set1_ps(v); }
+    inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    inline Vec fnmadd(Vec a, Vec b, Vec c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+    inline Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+    inline Vec sqrt(Vec v) { return _mm_sqrt_ps(v); }
+
+    inline float reduce(Vec v) {
+        Vec s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+
+    typedef __m128i Int;
+    typedef __m128 Mask;
+
+    inline Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+    inline Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+    inline Mask less(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+    inline Mask greater(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+    inline Mask equal(Vec a, Vec b) { return _mm_cmpeq_ps(a, b); }
+    inline Mask unordered(Vec a, Vec b) { return _mm_cmpunord_ps(a, b); }
+    inline Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    inline Mask both(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    inline Vec select(Mask m, Vec a, Vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+    inline Int set1_int(int32_t v) { return _mm_set1_epi32(v); }
+    inline Int round_to_int(Vec v) { return _mm_cvtps_epi32(v); }
+    inline Vec to_float(Int v) { return _mm_cvtepi32_ps(v); }
+    inline Int bits(Vec v) { return _mm_castps_si128(v); }
+    inline Vec from_bits(Int v) { return _mm_castsi128_ps(v); }
+    inline Int add_int(Int a, Int b) { return _mm_add_epi32(a, b); }
+    inline Int sub_int(Int a, Int b) { return _mm_sub_epi32(a, b); }
+    inline Int and_int(Int a, Int b) { return _mm_and_si128(a, b); }
+    inline Int or_int(Int a, Int b) { return _mm_or_si128(a, b); }
+    template<int N> inline Int shift_left(Int v) { return _mm_slli_epi32(v, N); }
+    template<int N> inline Int shift_right(Int v) { return _mm_srai_epi32(v, N); }
+#elif defined(SIMD_NEON)
+    constexpr const char *ISA = "neon";
+    constexpr size_t WIDTH = 4;
+    typedef float32x4_t Vec;
+
+    inline Vec load(const float *p) { return vld1q_f32(p); }
+    inline void store(float *p, Vec v) { vst1q_f32(p, v); }
+    inline Vec set1(float v) { return vdupq_n_f32(v); }
+    inline Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+    inline Vec sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+    inline Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+    inline Vec fmadd(Vec a, Vec b, Vec c) { return vfmaq_f32(c, a, b); }
+    inline Vec fnmadd(Vec a, Vec b, Vec c) { return vfmsq_f32(c, a, b); }
+    inline Vec div(Vec a, Vec b) { return vdivq_f32(a, b); }
+    inline Vec sqrt(Vec v) { return vsqrtq_f32(v); }
+    inline float reduce(Vec v) { return vaddvq_f32(v); }
+
+    typedef int32x4_t Int;
+    typedef uint32x4_t Mask;
+
+    inline Vec min(Vec a, Vec b) { return vminq_f32(a, b); }
+    inline Vec max(Vec a, Vec b) { return vmaxq_f32(a, b); }
+    inline Mask less(Vec a, Vec b) { return vcltq_f32(a, b); }
+    inline Mask greater(Vec a, Vec b) { return vcgtq_f32(a, b); }
+    inline Mask equal(Vec a, Vec b) { return vceqq_f32(a, b); }
+    inline Mask unordered(Vec a, Vec b) { return vmvnq_u32(vandq_u32(vceqq_f32(a, a), vceqq_f32(b, b))); }
+    inline Mask either(Mask a, Mask b) { return vorrq_u32(a, b); }
+    inline Mask both(Mask a, Mask b) { return vandq_u32(a, b); }
+    inline Vec select(Mask m, Vec a, Vec b) { return vbslq_f32(m, a, b); }
+
+    inline Int set1_int(int32_t v) { return vdupq_n_s32(v); }
+    inline Int round_to_int(Vec v) { return vcvtnq_s32_f32(v); }
+    inline Vec to_float(Int v) { return vcvtq_f32_s32(v); }
+    inline Int bits(Vec v) { return vreinterpretq_s32_f32(v); }
+    inline Vec from_bits(Int v) { return vreinterpretq_f32_s32(v); }
+    inline Int add_int(Int a, Int b) { return vaddq_s32(a, b); }
+    inline Int sub_int(Int a, Int b) { return vsubq_s32(a, b); }
+    inline Int and_int(Int a, Int b) { return vandq_s32(a, b); }
+    inline Int or_int(Int a, Int b) { return vorrq_s32(a, b); }
+    template<int N> inline Int shift_left(Int v) { return vshlq_n_s32(v, N); }
+    template<int N> inline Int shift_right(Int v) { return vshrq_n_s32(v, N); }
+#else
+    constexpr const char *ISA = "scalar";
+    constexpr size_t WIDTH = 1;
+    typedef float Vec;
+
+    inline Vec load(const float *p) { return *p; }
+    inline void store(float *p, Vec v) { *p = v; }
+    inline Vec set1(float v) { return v; }
+    inline Vec add(Vec a, Vec b) { return a + b; }
+    inline Vec sub(Vec a, Vec b) { return a - b; }
+    inline Vec mul(Vec a, Vec b) { return a * b; }
+    inline Vec fmadd(Vec a, Vec b, Vec c) { return std::fma(a, b, c); }
+    inline Vec fnmadd(Vec a, Vec b, Vec c) { return std::fma(-a, b, c); }
+    inline Vec div(Vec a, Vec b) { return a / b; }
+    inline Vec sqrt(Vec v) { return std::sqrt(v); }
+    inline float reduce(Vec v) { return v; }
+
+    typedef int32_t Int;
+    typedef bool Mask;
+
+    inline Vec min(Vec a, Vec b) { return b < a ? b : a; }
+    inline Vec max(Vec a, Vec b) { return b > a ? b : a; }
+    inline Mask less(Vec a, Vec b) { return a < b; }
+    inline Mask greater(Vec a, Vec b) { return a > b; }
+    inline Mask equal(Vec a, Vec b) { return a == b; }
+    inline Mask unordered(Vec a, Vec b) { return std::isnan(a) || std::isnan(b); }
+    inline Mask either(Mask a, Mask b) { return a || b; }
+    inline Mask both(Mask a, Mask b) { return a && b; }
+    inline Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+
+    inline Int set1_int(int32_t v) { return v; }
+    inline Int round_to_int(Vec v) { return static_cast<Int>(std::nearbyint(v)); }
+    inline Vec to_float(Int v) { return static_cast<float>(v); }
+    inline Int bits(Vec v) { Int i; std::memcpy(&i, &v, sizeof(i)); return i; }
+    inline Vec from_bits(Int i) { Vec v; std::memcpy(&v, &i, sizeof(v)); return v; }
+    inline Int add_int(Int a, Int b) { return static_cast<Int>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+    inline Int sub_int(Int a, Int b) { return static_cast<Int>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)); }
+    inline Int and_int(Int a, Int b) { return a & b; }
+    inline Int or_int(Int a, Int b) { return a | b; }
+    template<int N> inline Int shift_left(Int v) { return static_cast<Int>(static_cast<uint32_t>(v) << N); }
+    template<int N> inline Int shift_right(Int v) { return v >> N; }
+#endif
+
+    /* applies a scalar function to every lane, used for the transcendentals */
+    template<typename F>
+    inline Vec map(Vec v, F f) {
+        float lanes[WIDTH];
+        store(lanes, v);
+        for (float &lane : lanes) {
+            lane = f(lane);
+        }
+        return load(lanes);
+    }
+}
+
+#endif //FUNCTION_APPROXIMATION_SIMD_H
@@ -0,0 +1,100 @@
+#ifndef FUNCTION_APPROXIMATION_SUMMATION_H
+#define FUNCTION_APPROXIMATION_SUMMATION_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "simd.h"
+
+/*
+ * Summation engine for long float sums.
+ *
+ * A float running sum over n terms loses about n * ε of its value (ε = 2^-24), so Σx^4 or Σx^6 over
+ * millions of points has no correct digits left. Here the terms are summed in plain float over short
+ * blocks of SUM_BLOCK points only, which keeps the per point loops (and their SIMD) as fast as before,
+ * and every block sum goes into a compensated accumulator: TwoSum recovers the rounding error of each
+ * addition exactly and the errors are added back at the end. The result is as accurate as the sum of
+ * a single block, however many points there are.
+ */
+constexpr size_t SUM_BLOCK = 128;
+
+/* Knuth's TwoSum, branch free: sum + compensation carries about twice the precision of a float */
+struct CompensatedSum {
+    float sum = 0;
+    float compensation = 0;
+
+    void add(float v) {
+        float t = sum + v;
+        float bp = t - sum;
+        compensation += (sum - (t - bp)) + (v - bp);
+        sum = t;
+    }
+
+    float value() const {
+        return sum + compensation;
+    }
+};
+
+namespace simd {
+    /* CompensatedSum in every lane */
+    struct VecSum {
+        Vec sum = set1(0.0f);
+        Vec compensation = set1(0.0f);
+
+        void add(Vec v) {
+            Vec t = simd::add(sum, v);
+            Vec bp = sub(t, sum);
+            compensation = simd::add(compensation, simd::add(sub(sum, sub(t, bp)), sub(v, bp)));
+            sum = t;
+        }
+
+        /* the lanes folded together without losing the compensation */
+        CompensatedSum total() const {
+            float sums[WIDTH];
+            float compensations[WIDTH];
+            store(sums, sum);
+            store(compensations, compensation);
+
+            CompensatedSum s;
+            for (size_t l = 0; l < WIDTH; l++) {
+                s.add(sums[l]);
+            }
+            for (size_t l = 0; l < WIDTH; l++) {
+                s.add(compensations[l]);
+            }
+            return s;
+        }
+    };
+}
+
+/*
+ * Count sums over n points at once: terms(i, partial) adds the terms of point i to partial[0 .. Count),
+ * partial is a block sum that is moved into the compensated totals every SUM_BLOCK points
+ */
+template<size_t Count, typename Terms>
+std::array<float, Count> compensated_sums(size_t n, Terms terms) {
+    std::array<CompensatedSum, Count> total{};
+    std::array<float, Count> partial;
+
+    for (size_t begin = 0; begin < n; begin += SUM_BLOCK) {
+        size_t end = std::min(n, begin + SUM_BLOCK);
+
+        partial.fill(0.0f);
+        for (size_t i = begin; i < end; i++) {
+            terms(i, partial);
+        }
+
+        for (size_t k = 0; k < Count; k++) {
+            total[k].add(partial[k]);
+        }
+    }
+
+    std::array<float, Count> result;
+    for (size_t k = 0; k < Count; k++) {
+        result[k] = total[k].value();
+    }
+    return result;
+}
+
+#endif //FUNCTION_APPROXIMATION_SUMMATION_H
@@ -1,8 +1,70 @@
 #include "table.h"
 
-void printTable(const std::vector<std::string>& headers, const std::vector<std::vector<std::string>>& data) {
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+    /* the fixed-point text of a float is at most 39 integer digits, a sign, a point and the fraction */
+    const size_t CELL_BYTES = 64;
+
+    const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+    /*
+     * A float times 10^p (p <= 9) needs at most 24 + 21 significant bits, so the product is exact in double
+     * and rounding it to an integer half to even is exactly the rounding printf("%.*f") does.
+     * Other values (and the huge ones) go through std::to_chars, which gives the same text only slower.
+     */
+    size_t formatCell(char *cell, double value, int precision) {
+        double magnitude = std::abs(value);
+
+        if (precision >= 0 && precision <= 9 && magnitude < 1e9
+            && static_cast<double>(static_cast<float>(value)) == value) {
+            uint64_t scaled = static_cast<uint64_t>(std::nearbyint(magnitude * POWERS_OF_TEN[precision]));
+            uint64_t unit = static_cast<uint64_t>(POWERS_OF_TEN[precision]);
+            uint64_t integer = scaled / unit;
+            uint64_t fraction = scaled % unit;
+
+            char *p = cell;
+            if (std::signbit(value)) {
+                *p++ = '-';
+            }
+            p = std::to_chars(p, cell + CELL_BYTES, integer).ptr;
+
+            if (precision > 0) {
+                *p++ = '.';
+                for (int d = precision - 1; d >= 0; d--) {
+                    p[d] = static_cast<char>('0' + fraction % 10);
+                    fraction /= 10;
+                }
+                p += precision;
+            }
+
+            return static_cast<size_t>(p - cell);
+        }
+
+        std::to_chars_result result = std::to_chars(cell, cell + CELL_BYTES, value, std::chars_format::fixed,
+                                                    precision);
+        return static_cast<size_t>(result.ptr - cell);
+    }
+
+    void appendPadded(std::string &buffer, const char *text, size_t length, size_t width) {
+        if (length < width) {
+            buffer.append(width - length, ' ');
+        }
+        buffer.append(text, length);
+        buffer.append(" | ");
+    }
+}
+
+void printTable(const std::vector<std::string>& headers, const std::vector<std::vector<std::string>>& data,
+                std::ostream& out) {
+    PROFILE_SCOPE("printTable");
+
     if (headers.empty() || data.empty()) {
-        std::cout << "Table is empty." << std::endl;
+        out << "Table is empty.\n";
         return;
     }
 
@@ -17,25 +79,110 @@ void printTable(const std::vector<std::string>& headers, const std::vector<std::
         }
     }
 
+    std::string buffer;
     for (size_t i = 0; i < numColumns; ++i) {
-        std::cout << std::setw(columnWidths[i]) << headers[i] << " | ";
+        appendPadded(buffer, headers[i].data(), headers[i].length(), columnWidths[i]);
     }
-    std::cout << std::endl;
+    buffer += '\n';
 
     for (size_t i = 0; i < numColumns; ++i) {
-        std::cout << std::string(columnWidths[i], '-') << "-+-";
+        buffer.append(columnWidths[i], '-');
+        buffer.append("-+-");
     }
-    std::cout << std::endl;
+    buffer += '\n';
 
     for (const auto& row : data) {
         if (row.size() != numColumns) {
-            std::cout << "Invalid row size." << std::endl;
-            return;
+            buffer.append("Invalid row size.\n");
+            break;
         }
         for (size_t i = 0; i < numColumns; ++i) {
-            std::cout << std::setw(columnWidths[i]) << row[i] << " | ";
+            appendPadded(buffer, row[i].data(), row[i].length(), columnWidths[i]);
         }
-        std::cout << std::endl;
+        buffer += '\n';
     }
+
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
+TableWriter::TableWriter(std::vector<TableColumn> columns, size_t head, size_t tail)
+        : columns(std::move(columns)), head(head), tail(tail) {
+    values.resize(this->columns.size());
+    lowest.resize(this->columns.size());
+    highest.resize(this->columns.size());
+    widths.resize(this->columns.size());
+}
+
+void TableWriter::begin(size_t rows) {
+    skipped = (head > 0 || tail > 0) && rows > head + tail ? rows - head - tail : 0;
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        lowest[c] = std::numeric_limits<double>::infinity();
+        highest[c] = -std::numeric_limits<double>::infinity();
+        widths[c] = columns[c].header.length();
+    }
+
+    buffer.clear();
+    buffer.reserve(FLUSH_BYTES + FLUSH_BYTES / 4);
+}
+
+void TableWriter::bound() {
+    for (size_t c = 0; c < columns.size(); c++) {
+        double v = values[c];
+
+        if (!std::isfinite(v)) {
+            /* nan and inf have a text of their own and no place in the order */
+            char cell[CELL_BYTES];
+            widths[c] = std::max(widths[c], formatCell(cell, v, columns[c].precision));
+            continue;
+        }
+
+        /* -0 prints with a sign, so it counts as lower than 0 */
+        if (v < lowest[c] || (v == lowest[c] && std::signbit(v))) {
+            lowest[c] = v;
+        }
+        highest[c] = std::max(highest[c], v);
+    }
+}
+
+void TableWriter::writeHeader() {
+    char cell[CELL_BYTES];
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        if (lowest[c] <= highest[c]) {
+            widths[c] = std::max(widths[c], formatCell(cell, lowest[c], columns[c].precision));
+            widths[c] = std::max(widths[c], formatCell(cell, highest[c], columns[c].precision));
+        }
+    }
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        appendPadded(buffer, columns[c].header.data(), columns[c].header.length(), widths[c]);
+    }
+    buffer += '\n';
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        buffer.append(widths[c], '-');
+        buffer.append("-+-");
+    }
+    buffer += '\n';
+}
+
+void TableWriter::writeRow() {
+    char cell[CELL_BYTES];
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        appendPadded(buffer, cell, formatCell(cell, values[c], columns[c].precision), widths[c]);
+    }
+    buffer += '\n';
+}
+
+void TableWriter::writeSkipped() {
+    buffer.append("... ");
+    buffer.append(std::to_string(skipped));
+    buffer.append(" rows skipped ...\n");
+}
+
+void TableWriter::drain(std::ostream &out) {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
@@ -2,10 +2,103 @@
 #define FUNCTION_APPROXIMATION_TABLE_H
 
 #include <iostream>
-#include <iomanip>
 #include <vector>
 #include <string>
 
-void printTable(const std::vector<std::string>& headers, const std::vector<std::vector<std::string>>& data);
+#include "profile.h"
+
+void printTable(const std::vector<std::string>& headers, const std::vector<std::vector<std::string>>& data,
+                std::ostream& out = std::cout);
+
+/* a column of numbers printed with a fixed number of digits after the point (0 for row numbers) */
+struct TableColumn {
+    std::string header;
+    int precision = 6;
+};
+
+/*
+ * Streams a table of numbers without keeping its rows or cells as strings.
+ *
+ * The fixed-point text of a number only gets longer with more integer digits or a sign, so the width
+ * of a column is known from its smallest and largest value: the first pass over the rows only compares
+ * numbers, the second one formats every cell once straight into a large buffer. The buffer goes to the
+ * stream in big blocks and the stream is never flushed per line.
+ *
+ * With head or tail set and more rows than head + tail, only the first head and the last tail rows
+ * are printed, so a huge table costs bounded time and memory.
+ */
+class TableWriter {
+public:
+    explicit TableWriter(std::vector<TableColumn> columns, size_t head = 0, size_t tail = 0);
+
+    /* rowValues(i, values) writes the numbers of row i into values, one per column */
+    template<typename RowValues>
+    void write(size_t rows, RowValues rowValues, std::ostream &out = std::cout) {
+        PROFILE_SCOPE("TableWriter::write");
+
+        if (columns.empty() || rows == 0) {
+            out << "Table is empty.\n";
+            return;
+        }
+
+        begin(rows);
+        for (size_t i = firstRow(rows); i < rows; i = nextRow(i, rows)) {
+            rowValues(i, values.data());
+            bound();
+        }
+
+        writeHeader();
+        for (size_t i = firstRow(rows); i < rows; i = nextRow(i, rows)) {
+            if (skipped > 0 && i == rows - tail) {
+                writeSkipped();
+            }
+
+            rowValues(i, values.data());
+            writeRow();
+
+            if (buffer.size() >= FLUSH_BYTES) {
+                drain(out);
+            }
+        }
+
+        drain(out);
+    }
+
+private:
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    std::vector<TableColumn> columns;
+    size_t head;
+    size_t tail;
+
+    /* rows left out between the head and the tail of the current table */
+    size_t skipped = 0;
+
+    std::vector<double> values;
+    std::vector<double> lowest;
+    std::vector<double> highest;
+    std::vector<size_t> widths;
+    std::string buffer;
+
+    void begin(size_t rows);
+
+    size_t firstRow(size_t rows) const {
+        return skipped > 0 && head == 0 ? rows - tail : 0;
+    }
+
+    size_t nextRow(size_t row, size_t rows) const {
+        return skipped > 0 && row + 1 == head ? rows - tail : row + 1;
+    }
+
+    void bound();
+
+    void writeHeader();
+
+    void writeRow();
+
+    void writeSkipped();
+
+    void drain(std::ostream &out);
+};
 
 #endif //FUNCTION_APPROXIMATION_TABLE_H
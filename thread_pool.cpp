@@ -0,0 +1,42 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this]() {
+            while (true) {
+                std::function<void()> task;
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+                    if (stopping && tasks.empty()) {
+                        return;
+                    }
+
+                    task = std::move(tasks.front());
+                    tasks.pop();
+                }
+
+                task();
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
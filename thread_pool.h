@@ -0,0 +1,52 @@
+#ifndef FUNCTION_APPROXIMATION_THREAD_POOL_H
+#define FUNCTION_APPROXIMATION_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+ * fixed set of worker threads taking tasks from a shared queue;
+ * submit returns a future, so results and exceptions reach the caller in whatever order it asks for them
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template<typename F>
+    auto submit(F task) -> std::future<decltype(task())> {
+        auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+        std::future<decltype(task())> result = packaged->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([packaged]() { (*packaged)(); });
+        }
+        ready.notify_one();
+
+        return result;
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping = false;
+};
+
+#endif //FUNCTION_APPROXIMATION_THREAD_POOL_H
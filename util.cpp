@@ -1,9 +1,17 @@
 #include <vector>
 #include "util.h"
+#include "profile.h"
 
-bool hasNegativeNumber(std::vector<float>& numbers) {
-    for (int number : numbers) {
-        if (number < 0) {
+bool hasNegativeNumber(const std::vector<float>& numbers) {
+    return hasNegativeNumber(numbers.data(), numbers.size());
+}
+
+bool hasNegativeNumber(const float *numbers, size_t n) {
+    PROFILE_SCOPE("hasNegativeNumber");
+    PROFILE_COUNT("points", n);
+
+    for (size_t i = 0; i < n; i++) {
+        if (numbers[i] < 0) {
             return true;
         }
     }
@@ -1,8 +1,11 @@
 #ifndef FUNCTION_APPROXIMATION_UTIL_H
 #define FUNCTION_APPROXIMATION_UTIL_H
 
+#include <cstddef>
 #include <vector>
 
-bool hasNegativeNumber(std::vector<float>& numbers);
+bool hasNegativeNumber(const std::vector<float>& numbers);
+
+bool hasNegativeNumber(const float *numbers, size_t n);
 
 #endif //FUNCTION_APPROXIMATION_UTIL_H
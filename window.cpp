@@ -0,0 +1,48 @@
+#include "window.h"
+
+WindowFit::WindowFit(size_t window, size_t degree, size_t resyncEvery)
+        : window(window), resyncEvery(resyncEvery == 0 ? window : resyncEvery), moments(degree) {
+    if (window == 0) {
+        throw std::runtime_error("Window must hold at least one point!");
+    }
+
+    if (degree < 1 || degree > 10) {
+        throw std::runtime_error("Polynomial degree must be from 1 to 10!");
+    }
+
+    xs.reserve(window);
+    ys.reserve(window);
+}
+
+void WindowFit::add(float x, float y) {
+    if (xs.size() < window) {
+        xs.push_back(x);
+        ys.push_back(y);
+        moments.add(x, y);
+        return;
+    }
+
+    moments.remove(xs[oldest], ys[oldest]);
+    moments.add(x, y);
+
+    xs[oldest] = x;
+    ys[oldest] = y;
+    oldest = (oldest + 1) % window;
+
+    if (++sinceResync >= resyncEvery) {
+        resync();
+    }
+}
+
+void WindowFit::resync() {
+    moments = compute_moments(xs.data(), ys.data(), xs.size(), moments.degree);
+    sinceResync = 0;
+}
+
+std::pair<float, float> WindowFit::lineal() const {
+    return approx_lineal(moments);
+}
+
+Polynomial WindowFit::polynomial(size_t degree) const {
+    return polynomial_approximation(moments, degree);
+}
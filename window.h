@@ -0,0 +1,61 @@
+#ifndef FUNCTION_APPROXIMATION_WINDOW_H
+#define FUNCTION_APPROXIMATION_WINDOW_H
+
+#include <vector>
+
+#include "approximation.h"
+#include "moments.h"
+
+/*
+ * Least squares fits over the last W points of a stream.
+ *
+ * The window keeps its points in a ring buffer and the power sums of those points in Moments.
+ * A new point adds its contribution and, once the window is full, the departing point takes its
+ * own contribution back, so every update is O(degree) whatever W is.
+ *
+ * Adding and subtracting does not cancel exactly, even in double, the error of the sums grows with every update.
+ * Every resyncEvery updates the sums are recomputed from the buffer to keep that drift bounded,
+ * which costs O(W * degree) once per resyncEvery updates. A resync also centers the sums on the points
+ * of the window (see compute_moments), until the first one they are sums of x itself.
+ */
+class WindowFit {
+public:
+    /* resyncEvery = 0 means once per window length */
+    explicit WindowFit(size_t window, size_t degree = 1, size_t resyncEvery = 0);
+
+    void add(float x, float y);
+
+    /* recomputes the sums from the points in the window, centered on them */
+    void resync();
+
+    size_t size() const {
+        return moments.n;
+    }
+
+    bool full() const {
+        return moments.n == window;
+    }
+
+    const Moments &windowMoments() const {
+        return moments;
+    }
+
+    std::pair<float, float> lineal() const;
+
+    /* coefficients b_0, b_1, ..., b_degree of t in the scaling of the last resync */
+    Polynomial polynomial(size_t degree) const;
+
+private:
+    size_t window;
+    size_t resyncEvery;
+    size_t sinceResync = 0;
+
+    /* ring buffer, oldest is the index of the point that leaves the window next */
+    std::vector<float> xs;
+    std::vector<float> ys;
+    size_t oldest = 0;
+
+    Moments moments;
+};
+
+#endif //FUNCTION_APPROXIMATION_WINDOW_H